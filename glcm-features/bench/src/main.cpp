@@ -0,0 +1,290 @@
+#include "../../glcm/headers/glcm_features.h"
+
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#define DEFAULT_REPETITIONS 3
+#define DEFAULT_SAMPLED_WINDOWS 2000
+#define TEXTURE_SEED 12345
+
+/*
+Benchmark of glcm library on deterministic synthetic textures. Results are printed as JSON, one record per measured
+configuration, so they can be compared between releases.
+Usage: glcm_bench [--quick] [output.json]
+	--quick - only the smallest texture and one repetition, for smoke runs.
+	output.json - file for results, standard output when not given.
+*/
+
+enum TextureType {
+	NOISE_TEXTURE,
+	WAVES_TEXTURE
+};
+
+struct BenchRecord {
+	std::string benchmark;
+	std::string texture;
+	int width;
+	int height;
+	int grayLevels;
+	int windowSize;
+	int threads;
+	std::string mode;
+	std::string feature;
+	int repetitions;
+	double seconds;
+	double megapixelsPerSecond;
+	double windowNsP50;
+	double windowNsP90;
+	double windowNsP99;
+};
+
+/*
+Linear congruential generator, so textures are the same on every platform and standard library.
+*/
+unsigned int nextRandom(unsigned long long& state) {
+	state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+	return static_cast<unsigned int>(state >> 33);
+}
+
+/*
+Create 8-bit texture. Noise gives almost uniform GLCM, waves give GLCM concentrated near diagonal like natural textures.
+*/
+cv::Mat createTexture(TextureType textureType, int size) {
+	cv::Mat texture(size, size, CV_8UC1);
+	unsigned long long state = TEXTURE_SEED;
+	for (int i = 0; i < size; i++) {
+		uchar* row = texture.ptr<uchar>(i);
+		for (int j = 0; j < size; j++) {
+			int noise = nextRandom(state) % 256;
+			if (textureType == NOISE_TEXTURE) {
+				row[j] = static_cast<uchar>(noise);
+			}
+			else {
+				double wave = 96.0 * std::sin(j * 0.21 + 0.7 * std::sin(i * 0.05)) + 64.0 * std::cos(i * 0.13);
+				row[j] = static_cast<uchar>(std::clamp(128.0 + wave * 0.8 + (noise - 128) * 0.15, 0.0, 255.0));
+			}
+		}
+	}
+
+	return texture;
+}
+
+std::string stringifyTexture(TextureType textureType) {
+	return textureType == NOISE_TEXTURE ? "noise" : "waves";
+}
+
+std::string stringifyComputationMode(ComputationMode computationMode) {
+	switch (computationMode) {
+		case BRUTE_FORCE:
+			return "bruteForce";
+		case SLIDING_WINDOW:
+			return "sliding";
+		case INTEGRAL_HISTOGRAMS:
+			return "integral";
+		case COLUMN_HISTOGRAMS:
+			return "columns";
+	}
+	return "";
+}
+
+std::string stringifyFeature(FeatureType featureType) {
+	switch (featureType) {
+		case ENERGY:
+			return "energy";
+		case ENTROPY:
+			return "entropy";
+		case CONTRAST:
+			return "contrast";
+		case HOMOGENEITY:
+			return "homogeneity";
+	}
+	return "";
+}
+
+double percentile(std::vector<double> values, double fraction) {
+	if (values.empty()) {
+		return 0.0;
+	}
+
+	std::sort(values.begin(), values.end());
+	size_t index = static_cast<size_t>(fraction * (values.size() - 1) + 0.5);
+	return values[index];
+}
+
+void setWindowPercentiles(BenchRecord& record, const std::vector<double>& windowNs) {
+	record.windowNsP50 = percentile(windowNs, 0.5);
+	record.windowNsP90 = percentile(windowNs, 0.9);
+	record.windowNsP99 = percentile(windowNs, 0.99);
+}
+
+double elapsedNs(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+/*
+Measure GLCM of whole image and of single windows. Whole image gives throughput, windows are sampled on a regular grid
+and timed one by one to get latency percentiles.
+@param meanGLCM - benchmark calculateMeanGLCM() with all offsets instead of calculateGLCM() with the first one.
+*/
+BenchRecord benchGLCM(std::shared_ptr<Image> image, std::string texture, int windowSize, bool meanGLCM, int repetitions, const std::vector<std::pair<int, int>>& offsets) {
+	int width = image->getImageInfo().width;
+	int height = image->getImageInfo().height;
+	std::unique_ptr<GLCM> glcm = std::make_unique<GLCM>(image);
+
+	BenchRecord record{ meanGLCM ? "calculateMeanGLCM" : "calculateGLCM", texture, width, height, static_cast<int>(image->getImageInfo().grayLevelsAmount), windowSize, 1, "", "", repetitions };
+	auto start = std::chrono::steady_clock::now();
+	for (int r = 0; r < repetitions; r++) {
+		if (meanGLCM) {
+			glcm->calculateMeanGLCM(offsets, false);
+		}
+		else {
+			glcm->calculateGLCM(offsets.front(), false);
+		}
+	}
+	record.seconds = elapsedNs(start) / 1e9;
+	record.megapixelsPerSecond = static_cast<double>(width) * height * repetitions / 1e6 / record.seconds;
+
+	std::vector<double> windowNs;
+	int windowsPerAxis = static_cast<int>(std::sqrt(DEFAULT_SAMPLED_WINDOWS));
+	for (int a = 0; a < windowsPerAxis; a++) {
+		for (int b = 0; b < windowsPerAxis; b++) {
+			int top = (height - windowSize) * a / windowsPerAxis;
+			int left = (width - windowSize) * b / windowsPerAxis;
+			auto windowStart = std::chrono::steady_clock::now();
+			if (meanGLCM) {
+				glcm->calculateMeanGLCM(offsets, top, left, windowSize, false);
+			}
+			else {
+				glcm->calculateGLCM(offsets.front(), top, left, windowSize, false);
+			}
+			windowNs.push_back(elapsedNs(windowStart));
+		}
+	}
+	setWindowPercentiles(record, windowNs);
+
+	return record;
+}
+
+/*
+Measure feature maps of the whole image and features of single windows. Windows of one traversal can't be timed
+separately, so windows sampled on a regular grid are timed one by one as single point feature tables.
+*/
+BenchRecord benchFeature(std::shared_ptr<Image> image, std::string texture, int windowSize, int threads, ComputationMode computationMode, FeatureType featureType, int repetitions, const std::vector<std::pair<int, int>>& offsets) {
+	int width = image->getImageInfo().width;
+	int height = image->getImageInfo().height;
+
+	BenchRecord record{ "featureMaps", texture, width, height, static_cast<int>(image->getImageInfo().grayLevelsAmount), windowSize, threads, stringifyComputationMode(computationMode), stringifyFeature(featureType), repetitions };
+	double totalNs = 0.0;
+	for (int r = 0; r < repetitions; r++) {
+		std::unique_ptr<GLCM_features> glcmFeatures = std::make_unique<GLCM_features>(image, windowSize, computationMode);
+		glcmFeatures->setThreadsAmount(threads);
+
+		auto start = std::chrono::steady_clock::now();
+		std::vector<std::unique_ptr<Image>> featureImages = glcmFeatures->featureMaps(offsets, { featureType });
+		totalNs += elapsedNs(start);
+	}
+	record.seconds = totalNs / 1e9;
+	record.megapixelsPerSecond = static_cast<double>(width) * height * repetitions / 1e6 / record.seconds;
+
+	std::unique_ptr<GLCM_features> glcmFeatures = std::make_unique<GLCM_features>(image, windowSize, computationMode);
+	glcmFeatures->setThreadsAmount(threads);
+	std::vector<double> windowNs;
+	int windowsPerAxis = static_cast<int>(std::sqrt(DEFAULT_SAMPLED_WINDOWS));
+	for (int a = 0; a < windowsPerAxis; a++) {
+		for (int b = 0; b < windowsPerAxis; b++) {
+			// feature of pixel is calculated from window centered on it
+			int y = (height - windowSize) * a / windowsPerAxis + windowSize / 2;
+			int x = (width - windowSize) * b / windowsPerAxis + windowSize / 2;
+			auto windowStart = std::chrono::steady_clock::now();
+			FeatureTable featureTable = glcmFeatures->featureTable(offsets, { featureType }, std::vector<cv::Point>{ cv::Point(x, y) });
+			windowNs.push_back(elapsedNs(windowStart));
+		}
+	}
+	setWindowPercentiles(record, windowNs);
+
+	return record;
+}
+
+std::string toJson(const std::vector<BenchRecord>& records, unsigned int hardwareThreads) {
+	std::ostringstream json;
+	json << "{\n  \"hardwareThreads\": " << hardwareThreads << ",\n  \"simdLevel\": " << detectSimdLevel() << ",\n  \"results\": [\n";
+	for (size_t n = 0; n < records.size(); n++) {
+		const BenchRecord& r = records[n];
+		json << "    {\"benchmark\": \"" << r.benchmark << "\", \"texture\": \"" << r.texture << "\", \"width\": " << r.width
+			<< ", \"height\": " << r.height << ", \"grayLevels\": " << r.grayLevels << ", \"windowSize\": " << r.windowSize
+			<< ", \"threads\": " << r.threads << ", \"mode\": \"" << r.mode << "\", \"feature\": \"" << r.feature
+			<< "\", \"repetitions\": " << r.repetitions << ", \"seconds\": " << r.seconds
+			<< ", \"megapixelsPerSecond\": " << r.megapixelsPerSecond << ", \"windowNs\": {\"p50\": " << r.windowNsP50
+			<< ", \"p90\": " << r.windowNsP90 << ", \"p99\": " << r.windowNsP99 << "}}" << (n + 1 < records.size() ? "," : "") << "\n";
+	}
+	json << "  ]\n}\n";
+
+	return json.str();
+}
+
+int main(int argc, char** argv) {
+	bool quick = false;
+	std::string outputPath;
+	for (int a = 1; a < argc; a++) {
+		std::string argument = argv[a];
+		if (argument == "--quick") {
+			quick = true;
+		}
+		else {
+			outputPath = argument;
+		}
+	}
+
+	std::vector<int> textureSizes = quick ? std::vector<int>{ 128 } : std::vector<int>{ 128, 256, 512 };
+	std::vector<int> grayLevelsAmounts = { 8, 16, 32 };
+	std::vector<int> windowSizes = { 5, 9, 15 };
+	unsigned int hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+	std::vector<int> threadsAmounts = hardwareThreads > 1 ? std::vector<int>{ 1, static_cast<int>(hardwareThreads) } : std::vector<int>{ 1 };
+	// brute force is the baseline other modes are compared against
+	std::vector<ComputationMode> computationModes = { BRUTE_FORCE, SLIDING_WINDOW, INTEGRAL_HISTOGRAMS, COLUMN_HISTOGRAMS };
+	std::vector<FeatureType> featureTypes = { ENERGY, ENTROPY, CONTRAST, HOMOGENEITY };
+	std::vector<std::pair<int, int>> offsets = { {1, 0}, {0, 1}, {1, 1}, {-1, 1} };
+	int repetitions = quick ? 1 : DEFAULT_REPETITIONS;
+
+	std::vector<BenchRecord> records;
+	for (TextureType textureType : { NOISE_TEXTURE, WAVES_TEXTURE }) {
+		for (int textureSize : textureSizes) {
+			cv::Mat texture = createTexture(textureType, textureSize);
+			for (int grayLevelsAmount : grayLevelsAmounts) {
+				// feature images are named after source image and would be saved next to its directory, nothing is saved here
+				std::string texturePath = "bench/source/" + stringifyTexture(textureType) + "_" + std::to_string(textureSize) + ".pgm";
+				std::shared_ptr<Image> image = std::make_shared<Image>(texturePath, texture.clone(), grayLevelsAmount, 256);
+				std::cerr << "Benchmarking " << texturePath << " with " << grayLevelsAmount << " gray levels\n";
+
+				for (int windowSize : windowSizes) {
+					records.push_back(benchGLCM(image, stringifyTexture(textureType), windowSize, false, repetitions, offsets));
+					records.push_back(benchGLCM(image, stringifyTexture(textureType), windowSize, true, repetitions, offsets));
+
+					for (int threads : threadsAmounts) {
+						for (ComputationMode computationMode : computationModes) {
+							for (FeatureType featureType : featureTypes) {
+								records.push_back(benchFeature(image, stringifyTexture(textureType), windowSize, threads, computationMode, featureType, repetitions, offsets));
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+
+	std::string json = toJson(records, hardwareThreads);
+	if (outputPath.empty()) {
+		std::cout << json;
+	}
+	else {
+		std::ofstream output(outputPath);
+		output << json;
+		std::cerr << "Results saved to " << outputPath << "\n";
+	}
+
+	return 0;
+}
@@ -0,0 +1,17 @@
+#include <iostream>
+
+class BadConfig : public std::exception {
+private: 
+    std::string _configPath;
+    std::string _reason;
+public:
+    BadConfig(std::string configPath, std::string reason) {
+        this->_configPath = configPath;
+        this->_reason = reason;
+    }
+
+    std::string msg() {
+        std::string exceptionMessage = "Wrong batch config " + this->_configPath + ": " + this->_reason + "\n";
+        return exceptionMessage;
+    }
+};
\ No newline at end of file
@@ -0,0 +1,9 @@
+#include <iostream>
+
+class BadMask : public std::exception {
+public:
+    std::string msg() {
+        std::string exceptionMessage = "Wrong mask of pixels. Mask should be 8-bit single channel image of the same size as the image\n";
+        return exceptionMessage;
+    }
+};
\ No newline at end of file
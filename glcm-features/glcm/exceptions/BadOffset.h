@@ -3,7 +3,7 @@
 class BadOffset : public std::exception {
 public:
     std::string msg() {
-        std::string exceptionMessage = "Wrong offset for GLCM. Offset should be (1, 0), (0, 1), (1, 1) or (-1, 1) consider values as (dx, dy)\n";
+        std::string exceptionMessage = "Wrong offset for GLCM. Offset should be a non-zero (dx, dy) pair and every offset has to fit inside the smallest window\n";
         return exceptionMessage;
     }
 };
\ No newline at end of file
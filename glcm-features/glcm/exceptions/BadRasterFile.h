@@ -0,0 +1,15 @@
+#include <iostream>
+
+class BadRasterFile : public std::exception {
+private: 
+    std::string _path;
+public:
+    BadRasterFile(std::string path) {
+        this->_path = path;
+    }
+
+    std::string msg() {
+        std::string exceptionMessage = "Can't map raster file at " + this->_path + ". It should be binary PGM or raw 8-bit or 16-bit single band data of given sizes\n";
+        return exceptionMessage;
+    }
+};
\ No newline at end of file
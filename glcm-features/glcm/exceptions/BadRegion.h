@@ -0,0 +1,9 @@
+#include <iostream>
+
+class BadRegion : public std::exception {
+public:
+    std::string msg() {
+        std::string exceptionMessage = "Region of GLCM is outside rows covered by integral histograms or outside the image\n";
+        return exceptionMessage;
+    }
+};
\ No newline at end of file
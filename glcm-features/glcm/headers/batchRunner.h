@@ -0,0 +1,95 @@
+#pragma once
+
+// decoded images waiting for compute, besides the one being calculated and the one being decoded
+#define DEFAULT_PREFETCHED_IMAGES 1
+// feature images waiting for encoder, compute workers wait when the queue is full
+#define DEFAULT_ENCODE_QUEUE_SIZE 16
+#define DEFAULT_ENCODERS_AMOUNT 2
+
+#include "../headers/glcm_features.h"
+#include "../headers/image.h"
+#include "../headers/boundedQueue.h"
+#include "../exceptions/BadConfig.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <regex>
+#include <chrono>
+#include <atomic>
+#include <thread>
+#include <exception>
+#include <memory>
+#include <vector>
+#include <set>
+#include <utility>
+#include <algorithm>
+#include <opencv2/opencv.hpp>
+
+/*
+One feature calculation of the batch - all requested features of one quantized image with all window sizes
+and one offset (or mean of all offsets). Window sizes are calculated together in one traversal of the image.
+*/
+struct BatchJob {
+	std::shared_ptr<Image> image;
+	std::vector<unsigned int> windowSizes;
+	std::vector<std::pair<int, int>> offsets;
+	size_t firstBand;
+	unsigned long long windowsAmount;
+	unsigned long long cost;
+};
+
+/*
+Image decoded and quantized to all gray levels amounts ahead of computation, or error of its loading.
+*/
+struct PrefetchedImage {
+	std::string path;
+	std::vector<std::shared_ptr<Image>> images;
+	std::exception_ptr error;
+};
+
+/*
+Work of encoder - single feature image, or stack of all feature images of one input when stacked output format is used.
+*/
+struct EncodeTask {
+	std::unique_ptr<Image> featureImage;
+	std::shared_ptr<FeatureStack> featureStack;
+};
+
+/*
+Runs parameter sweep described in config file. Every image is decoded once, all gray level reductions are derived
+from its single histogram and all feature calculations are scheduled over available threads. Decoding of the next
+image and encoding of feature images run in own threads connected with compute by bounded queues.
+*/
+class BatchRunner {
+private:
+	std::string _configPath;
+	std::vector<std::string> _imagePaths;
+	std::vector<int> _grayLevels;
+	std::vector<unsigned int> _windowSizes;
+	std::vector<std::pair<int, int>> _offsets;
+	std::set<FeatureType> _featureTypes;
+	bool _meanGLCM;
+	unsigned int _threadsAmount;
+	unsigned int _encodersAmount;
+	ComputationMode _computationMode;
+	GLCMStorage _storage;
+	FeatureImageFormat _outputFormat;
+	StackCompression _compression;
+
+	void parseConfig();
+	void parseConfigEntry(std::string key, std::string value, int lineNumber);
+	std::vector<std::string> splitValues(std::string value);
+	std::vector<std::shared_ptr<Image>> loadQuantizedImages(std::string path);
+	std::vector<BatchJob> createJobs(std::vector<std::shared_ptr<Image>>& images);
+	void decodeImages(BoundedQueue<PrefetchedImage>& prefetchedImages);
+	void encodeImages(BoundedQueue<EncodeTask>& encodeTasks, std::exception_ptr& error);
+	bool isOutputStacked();
+	void runJobs(std::vector<BatchJob>& jobs, BoundedQueue<EncodeTask>& encodeTasks, std::shared_ptr<FeatureStack> featureStack);
+	void runJob(BatchJob& job, unsigned int threadsAmount, BoundedQueue<EncodeTask>& encodeTasks, std::shared_ptr<FeatureStack> featureStack);
+
+public:
+	BatchRunner(std::string configPath);
+
+	void run();
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <utility>
+#include <algorithm>
+
+/*
+Queue between stages of a pipeline. Push blocks while the queue is full, so a fast producer can't hold more than
+capacity items, pop blocks while the queue is empty. Closed queue accepts no more items, pop returns remaining
+items and then false.
+*/
+template <typename T>
+class BoundedQueue {
+private:
+	std::deque<T> _items;
+	size_t _capacity;
+	bool _closed;
+	std::mutex _mutex;
+	std::condition_variable _notFull;
+	std::condition_variable _notEmpty;
+
+public:
+	BoundedQueue(size_t capacity) {
+		this->_capacity = std::max<size_t>(1, capacity);
+		this->_closed = false;
+	}
+
+	/*
+	@return false if queue was closed and item was dropped.
+	*/
+	bool push(T item) {
+		std::unique_lock<std::mutex> lock(this->_mutex);
+		this->_notFull.wait(lock, [this]() { return this->_closed || this->_items.size() < this->_capacity; });
+		if (this->_closed) {
+			return false;
+		}
+
+		this->_items.push_back(std::move(item));
+		this->_notEmpty.notify_one();
+		return true;
+	}
+
+	/*
+	@return false if queue is closed and empty.
+	*/
+	bool pop(T& item) {
+		std::unique_lock<std::mutex> lock(this->_mutex);
+		this->_notEmpty.wait(lock, [this]() { return this->_closed || !this->_items.empty(); });
+		if (this->_items.empty()) {
+			return false;
+		}
+
+		item = std::move(this->_items.front());
+		this->_items.pop_front();
+		this->_notFull.notify_one();
+		return true;
+	}
+
+	void close() {
+		std::lock_guard<std::mutex> lock(this->_mutex);
+		this->_closed = true;
+		this->_notFull.notify_all();
+		this->_notEmpty.notify_all();
+	}
+};
@@ -0,0 +1,58 @@
+#pragma once
+
+#define DEFAULT_COLUMN_HISTOGRAMS_MEMORY_BUDGET (512ULL * 1024 * 1024)
+
+#include "../headers/glcm.h"
+#include "../headers/image.h"
+#include "../headers/glcmView.h"
+
+#include <iostream>
+#include <vector>
+#include <utility>
+#include <tuple>
+#include <cstdint>
+#include <opencv2/opencv.hpp>
+
+/*
+Co-occurrence histograms of image columns (Perreault and Hebert, constant time median filter). For every offset and
+every column keeps counts of pairs with first pixel in that column and in rows of the current window. Histograms slide
+down by one row with two updates per column, window slides right by adding histogram of the entering column and
+subtracting the leaving one. Cost of every window is O(offsets * codes) regardless of window size, so it pays off for
+big windows with few codes (small L or SUM_DIFF_HISTOGRAMS storage). GLCM is not symmetric (horizontal = false).
+*/
+class ColumnGLCM {
+private:
+	std::shared_ptr<Image> _image;
+	cv::Mat _levelIndices;
+	std::vector<std::pair<int, int>> _offsets;
+	GLCMStorage _storage;
+	unsigned int _size;
+	unsigned int _codesAmount;
+	int _width;
+	int _windowSize;
+	std::vector<uint32_t> _columnHistograms;
+	int _histogramsTop;
+
+	std::vector<unsigned long long> _glcm;
+	std::vector<unsigned long long> _offsetWeights;
+	unsigned long long _pairsAmount;
+	int _top;
+	int _left;
+
+	uint32_t* columnHistogram(int offsetIndex, int col);
+	void addHistogramsRow(int offsetIndex, int row, uint32_t weight);
+	void addColumn(int offsetIndex, int col, unsigned long long weight);
+	void moveHistograms(int top);
+
+public:
+	ColumnGLCM(std::shared_ptr<Image> image, const std::vector<std::pair<int, int>>& offsets, int windowSize, GLCMStorage storage = FULL_MATRIX);
+
+	static unsigned long long calcMemorySize(unsigned int width, unsigned int grayLevelsAmount, unsigned int offsetsAmount, GLCMStorage storage);
+
+	void startColumnGLCM(int top, int left);
+	void slideGLCMRight();
+
+	GLCMView getGLCM();
+	SumDiffView getSumDiffHistograms();
+	GLCMStorage getStorage();
+};
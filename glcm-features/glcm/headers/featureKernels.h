@@ -0,0 +1,126 @@
+#pragma once
+
+#include "../headers/glcmView.h"
+
+#include <array>
+#include <vector>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define GLCM_X86_KERNELS
+#endif
+
+// SIMD kernels convert counts to double with exponent trick, which is exact only for values below 2^52
+#define SIMD_MAX_PAIRS_AMOUNT (1ULL << 52)
+// biggest count with precomputed count * log(count), bigger counts call std::log
+#define MAX_ENTROPY_TABLE_COUNT (1 << 20)
+
+struct FeatureValues {
+    double energy;
+    double entropy;
+    double contrast;
+    double homogeneity;
+};
+
+enum SimdLevel {
+	SIMD_NONE,
+	SIMD_SSE2,
+	SIMD_AVX2
+};
+
+/*
+Contrast and homogeneity weights of every GLCM cell for gray levels amount known only at runtime
+and table of count * log(count) for entropy, indexed by count.
+*/
+struct FeatureWeights {
+    std::vector<double> contrast;
+    std::vector<double> homogeneity;
+    std::vector<double> countLogCount;
+};
+
+/*
+Turn sums over GLCM counts into features of normalized GLCM: P(i, j) = counts[i * size + j] / pairsAmount.
+*/
+inline FeatureValues normalizeFeatureSums(double energy, double countLogCountSum, double contrast, double homogeneity, unsigned long long pairsAmount) {
+	double total = static_cast<double>(pairsAmount);
+	FeatureValues values;
+	values.energy = energy / (total * total);
+	values.entropy = std::log(total) - countLogCountSum / total;
+	values.contrast = contrast / total;
+	values.homogeneity = homogeneity / total;
+
+	return values;
+}
+
+double sumCountLogCount(const unsigned long long* counts, unsigned int cellsAmount, const std::vector<double>& countLogCountTable);
+
+/*
+Table of (i - j)^2 for every cell of L x L GLCM.
+*/
+template <unsigned int L>
+constexpr std::array<double, L * L> makeContrastWeights() {
+	std::array<double, L * L> weights{};
+	for (int i = 0; i < static_cast<int>(L); i++) {
+		for (int j = 0; j < static_cast<int>(L); j++) {
+			weights[i * L + j] = static_cast<double>((i - j) * (i - j));
+		}
+	}
+
+	return weights;
+}
+
+/*
+Table of 1 / (1 + (i - j)^2) for every cell of L x L GLCM.
+*/
+template <unsigned int L>
+constexpr std::array<double, L * L> makeHomogeneityWeights() {
+	std::array<double, L * L> weights{};
+	for (int i = 0; i < static_cast<int>(L); i++) {
+		for (int j = 0; j < static_cast<int>(L); j++) {
+			weights[i * L + j] = 1.0 / static_cast<double>(1 + (i - j) * (i - j));
+		}
+	}
+
+	return weights;
+}
+
+/*
+Evaluate features of GLCM with gray levels amount known at compile time. Loops have fixed trip count and
+weights come from constexpr tables, so compiler can unroll and vectorize them.
+@param counts - contiguous L x L matrix of GLCM counts.
+@param pairsAmount - sum of counts.
+@param countLogCountTable - count * log(count) for counts smaller than table size.
+@param entropyNeeded - entropy is calculated only on demand.
+*/
+template <unsigned int L>
+FeatureValues calcFeatureValuesFixed(const unsigned long long* counts, unsigned long long pairsAmount, const std::vector<double>& countLogCountTable, bool entropyNeeded) {
+	static constexpr std::array<double, L * L> contrastWeights = makeContrastWeights<L>();
+	static constexpr std::array<double, L * L> homogeneityWeights = makeHomogeneityWeights<L>();
+
+	double energy = 0.0;
+	double contrast = 0.0;
+	double homogeneity = 0.0;
+	for (unsigned int k = 0; k < L * L; k++) {
+		double count = static_cast<double>(counts[k]);
+		energy += count * count;
+		contrast += count * contrastWeights[k];
+		homogeneity += count * homogeneityWeights[k];
+	}
+
+	double entropy = entropyNeeded ? sumCountLogCount(counts, L * L, countLogCountTable) : 0.0;
+
+	return normalizeFeatureSums(energy, entropy, contrast, homogeneity, pairsAmount);
+}
+
+FeatureWeights makeFeatureWeights(unsigned int size);
+std::vector<double> makeCountLogCountTable(unsigned long long maxCount);
+SimdLevel detectSimdLevel();
+
+FeatureValues calcFeatureValuesGeneric(GLCMView glcm, const FeatureWeights& weights, bool entropyNeeded);
+#ifdef GLCM_X86_KERNELS
+FeatureValues calcFeatureValuesSse2(GLCMView glcm, const FeatureWeights& weights, bool entropyNeeded);
+FeatureValues calcFeatureValuesAvx2(GLCMView glcm, const FeatureWeights& weights, bool entropyNeeded);
+#endif
+FeatureValues calcFeatureValues(GLCMView glcm, const FeatureWeights& weights, bool entropyNeeded, SimdLevel simdLevel);
+FeatureValues calcSumDiffFeatureValues(SumDiffView histograms, const FeatureWeights& weights, bool entropyNeeded);
+FeatureValues calcSparseFeatureValues(SparseGLCMView glcm, const FeatureWeights& weights, bool entropyNeeded);
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "../headers/image.h"
+#include "../headers/stripWriter.h"
+#include "../headers/instrumentation.h"
+
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <opencv2/opencv.hpp>
+
+enum StackCompression {
+	STACK_UNCOMPRESSED,
+	STACK_LZW,
+	STACK_DEFLATE
+};
+
+/*
+All feature bands of one input saved into one file instead of one file per band. STACKED_TIFF is multi-page float TIFF,
+one page per band, optionally compressed. STACKED_NPY is uncompressed (bands, rows, cols) float32 NumPy array.
+Names of bands in order of pages are saved next to it in "<name>_bands.txt", one "<index> <band name>" per line.
+Bands can be set from several threads and in any order, their order in file is given by their indices.
+*/
+class FeatureStack {
+private:
+	std::string _name;
+	std::string _directoryPath;
+	StackCompression _compression;
+	std::vector<std::string> _bandNames;
+	std::vector<cv::Mat> _bands;
+	std::mutex _mutex;
+
+	bool saveTiff(std::string path);
+	bool saveNpy(std::string path);
+	bool saveBandIndex(std::string path);
+
+public:
+	FeatureStack(std::string name, size_t bandsAmount, StackCompression compression = STACK_UNCOMPRESSED);
+
+	void setBand(size_t bandIndex, std::unique_ptr<Image>& featureImage);
+	bool save(FeatureImageFormat outputFormat);
+};
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "../headers/stripWriter.h"
+#include "../headers/instrumentation.h"
+
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <limits>
+#include <cmath>
+#include <algorithm>
+#include <opencv2/opencv.hpp>
+
+/*
+Features of selected pixels, one row per pixel and one column per feature and window size. Values are CV_32FC1 like
+feature images, NaN marks window which does not fit the image around the pixel.
+*/
+class FeatureTable {
+private:
+	std::vector<cv::Point> _points;
+	std::vector<std::string> _columnNames;
+	cv::Mat _values;
+
+public:
+	FeatureTable(std::vector<cv::Point> points, std::vector<std::string> columnNames);
+
+	void setValue(int row, int column, double value);
+
+	bool saveCsv(std::string path);
+	bool saveNpy(std::string path);
+
+	std::vector<cv::Point> getPoints();
+	std::vector<std::string> getColumnNames();
+	cv::Mat getValues();
+};
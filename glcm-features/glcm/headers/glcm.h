@@ -1,42 +1,90 @@
 ﻿#pragma once
 
 #include "../headers/image.h"
+#include "../headers/glcmView.h"
+#include "../headers/featureKernels.h"
 #include "../exceptions/BadOffset.h"
-#include "../exceptions/BadPixelValue.h"
-#include "../exceptions/NoOffsets.h"
+#include "../exceptions/noOffsets.h"
 
 #include <iostream>
 #include <vector>
 #include <utility>
+#include <tuple>
+#include <algorithm>
+#include <numeric>
+#include <climits>
 #include <opencv2/opencv.hpp>
 
+enum GLCMStorage {
+	FULL_MATRIX,
+	SUM_DIFF_HISTOGRAMS,
+	SPARSE_MATRIX
+};
+
 class GLCM {
 private:
 	std::shared_ptr<Image> _image;
-	std::shared_ptr<std::shared_ptr<double[]>[]> _glcm;
+	std::vector<unsigned long long> _glcm;
+	unsigned long long _pairsAmount;
 	std::vector<unsigned int> _greyLevels;
+	cv::Mat _levelIndices;
 	unsigned int _size;
+	GLCMStorage _storage;
+	std::vector<ushort> _occupiedCodes;
+
+	std::vector<std::pair<int, int>> _slidingOffsets;
+	std::vector<unsigned long long> _offsetWeights;
+	std::vector<unsigned long long> _slidingWeights;
+	int _slidingTop;
+	int _slidingLeft;
+	int _slidingWindowSize;
+	bool _slidingHorizontal;
+
+	std::vector<std::pair<int, int>> _pairCodesOffsets;
+	std::vector<cv::Mat> _pairCodes;
+	std::vector<ushort> _transposedCodes;
+	std::vector<ushort> _sumBins;
+	std::vector<ushort> _differenceBins;
 
 	void clearGLCM();
-	bool checkOffset(std::pair<int, int> offset);
-	unsigned int findGreyLevelValueInVector(unsigned int value);
-	void makeGLCMHorizontal();
-	void normalizeGLCM();
-	std::unique_ptr<std::unique_ptr<double[]>[]> createTransponedGLCM();
-	void addIntermediateGLCM(std::shared_ptr<std::shared_ptr<double[]>[]> glcm);
+	void addSparseCount(unsigned int code, unsigned long long weight);
+	void createPairCodeTables();
+	void loadPairCodes(const std::vector<std::pair<int, int>>& offsets);
+	void addPairs(int offsetIndex, int firstRow, int lastRow, int firstCol, int lastCol, bool horizontal, long long weight);
+	unsigned long long calcOffsetWeights(const std::vector<std::pair<int, int>>& offsets, int height, int width, bool horizontal);
+	void addRowPairs(const uchar* currentRow, const uchar* neighbourRow, int firstCol, int lastCol, bool horizontal, unsigned long long weight);
+	void addRowPairCodes(const ushort* pairCodeRow, int firstCol, int lastCol, bool horizontal, unsigned long long weight);
+	void addMeanPairs(const std::vector<std::pair<int, int>>& offsets, int top, int left, int height, int width, bool horizontal);
+	void fillSlidingGLCM(const std::vector<std::pair<int, int>>& offsets, int top, int left, int windowSize, bool horizontal);
 
 public:
-	GLCM(std::shared_ptr<Image> image);
+	GLCM(std::shared_ptr<Image> image, GLCMStorage storage = FULL_MATRIX);
+
+	static bool checkOffset(std::pair<int, int> offset);
+	static std::tuple<int, int, int, int> getPairsRange(std::pair<int, int> offset, int top, int left, int height, int width);
+	static unsigned long long countPairsInRange(std::tuple<int, int, int, int> pairsRange, bool horizontal);
+	static unsigned long long calcOffsetWeights(const std::vector<std::pair<int, int>>& offsets, int height, int width, bool horizontal, std::vector<unsigned long long>& offsetWeights);
 
 	void calculateGLCM(std::pair<int, int> offset, bool horizontal = true);
-	void calculateMeanGLCM(std::vector<std::pair<int, int>> offsets, bool horizontal = true);
+	void calculateMeanGLCM(const std::vector<std::pair<int, int>>& offsets, bool horizontal = true);
 
 	void calculateGLCM(std::pair<int, int> offset, int top, int left, int windowSize, bool horizontal = true);
-	void calculateMeanGLCM(std::vector<std::pair<int, int>> offsets, int top, int left, int windowSize, bool horizontal = true);
+	void calculateMeanGLCM(const std::vector<std::pair<int, int>>& offsets, int top, int left, int windowSize, bool horizontal = true);
+
+	void startSlidingGLCM(const std::vector<std::pair<int, int>>& offsets, int top, int left, int windowSize, bool horizontal = true);
+	void slideGLCMRight();
+	void slideGLCMLeft();
+	void slideGLCMDown();
+	void expandSlidingGLCM(int windowSize);
+
+	unsigned long long calcWindowPairsAmount(const std::vector<std::pair<int, int>>& offsets, int windowSize, bool horizontal = true);
 	
 	void printGLCM(unsigned int coutPrecision = 0);
 
-	std::shared_ptr<std::shared_ptr<double[]>[]> getGLCM();
+	GLCMView getGLCM();
+	SumDiffView getSumDiffHistograms();
+	SparseGLCMView getSparseGLCM();
+	GLCMStorage getStorage();
 	int getSize();
 	std::shared_ptr<Image> getImage();
 };
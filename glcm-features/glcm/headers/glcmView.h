@@ -0,0 +1,33 @@
+#pragma once
+
+/*
+Non-owning view of GLCM. Normalized value of GLCM in (i, j) point is counts[i * size + j] / pairsAmount.
+*/
+struct GLCMView {
+    const unsigned long long* counts;
+    unsigned int size;
+    unsigned long long pairsAmount;
+};
+
+/*
+Non-owning view of sum and difference histograms of pairs. Both have 2 * size - 1 bins, bin k of sum histogram
+counts pairs with i + j = k, bin k of difference histogram counts pairs with i - j = k - (size - 1).
+*/
+struct SumDiffView {
+    const unsigned long long* sumHistogram;
+    const unsigned long long* differenceHistogram;
+    unsigned int size;
+    unsigned long long pairsAmount;
+};
+
+/*
+Non-owning view of sparse GLCM. Counts are contiguous size x size matrix like in GLCMView, but only cells listed
+in occupiedCodes (i * size + j, ascending) are non-zero, so features can skip the rest of matrix.
+*/
+struct SparseGLCMView {
+    const unsigned long long* counts;
+    const unsigned short* occupiedCodes;
+    unsigned int occupiedAmount;
+    unsigned int size;
+    unsigned long long pairsAmount;
+};
@@ -1,15 +1,29 @@
 #pragma once
 
 #define DEFAULT_WINDOW_SIZE 7
+#define DEFAULT_THREADS_AMOUNT 1
+// FULL_MATRIX storage switches to SPARSE_MATRIX for windows with at least this many GLCM cells per pair
+#define SPARSE_GLCM_CELLS_PER_PAIR 16
 
 #include "../headers/glcm.h"
+#include "../headers/integralGLCM.h"
+#include "../headers/columnGLCM.h"
 #include "../headers/image.h"
+#include "../headers/featureKernels.h"
+#include "../headers/featureStack.h"
+#include "../headers/featureTable.h"
 #include "../exceptions/badFeatureType.h"
+#include "../exceptions/BadMask.h"
 
 #include <iostream>
 #include <cmath>
 #include <vector>
+#include <set>
 #include <utility>
+#include <thread>
+#include <exception>
+#include <algorithm>
+#include <numeric>
 #include <opencv2/opencv.hpp>
 
 enum FeatureType {
@@ -19,27 +33,67 @@ enum FeatureType {
 	HOMOGENEITY
 };
 
+enum ComputationMode {
+	BRUTE_FORCE,
+	SLIDING_WINDOW,
+	INTEGRAL_HISTOGRAMS,
+	COLUMN_HISTOGRAMS
+};
+
 class GLCM_features {
 private:
 	std::shared_ptr<Image> _image;
 	std::vector<unsigned int> _greyLevels;
 	unsigned int _windowSize;
+	std::vector<unsigned int> _windowSizes;
+	ComputationMode _computationMode;
+	unsigned int _threadsAmount;
+	GLCMStorage _storage;
+	FeatureWeights _featureWeights;
+	SimdLevel _simdLevel;
+	FeatureImageFormat _outputFormat;
+	StackCompression _compression;
 
-	void validWindowSize(unsigned int windowSize);
+	unsigned int validWindowSize(unsigned int windowSize);
 	bool checkIfWindowSizeOdd(unsigned int windowSize);
 	bool checkIfWindowSizeWithinImageSizes(unsigned int windowSize);
 	std::tuple<int, int, int, int> setStartingWindowParams();
-	void calcFeatureFromGLCM(std::pair<int, int> offset, FeatureType featureType);
-	void calcFeatureFromGLCM(std::vector<std::pair<int, int>> offsets, FeatureType featureType);
-	double calcEnergy(std::unique_ptr<GLCM>& glcm);
-	double calcEntropy(std::unique_ptr<GLCM>& glcm);
-	double calcContrast(std::unique_ptr<GLCM>& glcm);
-	double calcHomogeneity(std::unique_ptr<GLCM>& glcm);
+	GLCMStorage selectGLCMStorage(std::vector<std::pair<int, int>>& offsets, unsigned int windowSize);
+	void calcFeatureFromGLCM(std::pair<int, int> offset, std::vector<FeatureType> featureTypes);
+	void calcFeatureFromGLCM(std::vector<std::pair<int, int>> offsets, std::vector<FeatureType> featureTypes);
+	void calcFeatureImages(std::vector<std::pair<int, int>> offsets, std::vector<FeatureType> featureTypes, std::string offsetAsString);
+	std::vector<std::unique_ptr<Image>> calcFeatureMaps(std::vector<std::pair<int, int>> offsets, std::vector<FeatureType> featureTypes, std::string offsetAsString);
+	void prepareFeatureCalculation(std::vector<std::pair<int, int>>& offsets, std::vector<FeatureType>& featureTypes);
+	FeatureTable calcFeatureTable(std::vector<std::pair<int, int>> offsets, std::vector<FeatureType> featureTypes, std::vector<cv::Point> points);
+	void calcFeatureTableRows(std::vector<std::pair<int, int>>& offsets, std::vector<FeatureType>& featureTypes, std::vector<size_t>& pointsOrder, size_t first, size_t last, FeatureTable& featureTable);
+	std::vector<cv::Point> findMaskPoints(cv::Mat mask);
+	void calcFeatureBand(std::vector<std::pair<int, int>>& offsets, std::vector<FeatureType>& featureTypes, std::vector<std::unique_ptr<Image>>& textureFeatureImages, int firstRow, int lastRow);
+	void calcFeatureWithSlidingWindow(std::vector<std::pair<int, int>>& offsets, std::vector<FeatureType>& featureTypes, std::vector<std::unique_ptr<Image>>& textureFeatureImages, int firstRow, int lastRow);
+	void calcFeatureWithIntegralHistograms(std::vector<std::pair<int, int>>& offsets, std::vector<FeatureType>& featureTypes, std::vector<std::unique_ptr<Image>>& textureFeatureImages, int firstRow, int lastRow);
+	void calcFeatureWithColumnHistograms(std::vector<std::pair<int, int>>& offsets, std::vector<FeatureType>& featureTypes, std::vector<std::unique_ptr<Image>>& textureFeatureImages, int firstRow, int lastRow);
+	void setFeaturePixels(std::vector<double> results, std::vector<std::unique_ptr<Image>>& textureFeatureImages, int firstImage, int row, int col);
+	std::vector<std::tuple<int, int, int, int>> calcWindowCenterRanges();
+	bool checkIfWindowCenterCorrect(std::tuple<int, int, int, int>& centerRange, int row, int col);
+	std::vector<double> calcFeatures(std::unique_ptr<GLCM>& glcm, std::vector<FeatureType>& featureTypes);
+	std::vector<double> calcFeatures(std::unique_ptr<IntegralGLCM>& integralGLCM, std::vector<FeatureType>& featureTypes);
+	std::vector<double> calcFeatures(std::unique_ptr<ColumnGLCM>& columnGLCM, std::vector<FeatureType>& featureTypes);
+	bool isEntropyNeeded(std::vector<FeatureType>& featureTypes);
+	std::vector<double> orderFeatureValues(FeatureValues values, std::vector<FeatureType>& featureTypes);
 	std::string createFeatureTypeImageName(FeatureType featureType);
 	std::string stringifyFeatureType(FeatureType featureType);
 
 public:
-	GLCM_features(std::shared_ptr<Image> image, unsigned int windowSize = DEFAULT_WINDOW_SIZE);
+	GLCM_features(std::shared_ptr<Image> image, unsigned int windowSize = DEFAULT_WINDOW_SIZE, ComputationMode computationMode = SLIDING_WINDOW);
+	GLCM_features(std::shared_ptr<Image> image, std::vector<unsigned int> windowSizes, ComputationMode computationMode = SLIDING_WINDOW);
+
+	void setComputationMode(ComputationMode computationMode);
+	void setThreadsAmount(unsigned int threadsAmount);
+	void setSimdLevel(SimdLevel simdLevel);
+	void setGLCMStorage(GLCMStorage storage);
+	void setOutputFormat(FeatureImageFormat outputFormat);
+	void setStackCompression(StackCompression compression);
+	bool isFeatureExact(FeatureType featureType);
+	static void saveFeatureImage(std::unique_ptr<Image>& textureFeatureImage, FeatureImageFormat outputFormat);
 
 	void energy(std::pair<int, int> offset);
 	void energy(std::vector<std::pair<int, int>> offsets);
@@ -49,4 +103,15 @@ public:
 	void contrast(std::vector<std::pair<int, int>> offsets);
 	void homogeneity(std::pair<int, int> offset);
 	void homogeneity(std::vector<std::pair<int, int>> offsets);
+
+	void features(std::pair<int, int> offset, std::set<FeatureType> featureTypes);
+	void features(std::vector<std::pair<int, int>> offsets, std::set<FeatureType> featureTypes);
+
+	std::vector<std::unique_ptr<Image>> featureMaps(std::pair<int, int> offset, std::set<FeatureType> featureTypes);
+	std::vector<std::unique_ptr<Image>> featureMaps(std::vector<std::pair<int, int>> offsets, std::set<FeatureType> featureTypes);
+
+	FeatureTable featureTable(std::pair<int, int> offset, std::set<FeatureType> featureTypes, std::vector<cv::Point> points);
+	FeatureTable featureTable(std::vector<std::pair<int, int>> offsets, std::set<FeatureType> featureTypes, std::vector<cv::Point> points);
+	FeatureTable featureTable(std::pair<int, int> offset, std::set<FeatureType> featureTypes, cv::Mat mask);
+	FeatureTable featureTable(std::vector<std::pair<int, int>> offsets, std::set<FeatureType> featureTypes, cv::Mat mask);
 };
@@ -0,0 +1,48 @@
+#pragma once
+
+#define HISTOGRAM_BINS_AMOUNT 256
+// rows quantized together for all gray levels amounts, so source rows are still in cache for the next tables
+#define DEFAULT_QUANTIZATION_BLOCK_SIZE (256 * 1024)
+
+#include "../headers/instrumentation.h"
+
+#include <iostream>
+#include <array>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <opencv2/opencv.hpp>
+
+/*
+8-bit image reduced to given amount of gray levels. Pixels are snapped to the lowest value of their level,
+level indices (0..grayLevelsAmount - 1) are used as GLCM indices.
+*/
+struct QuantizedPixels {
+	int grayLevelsAmount;
+	cv::Mat pixels;
+	cv::Mat levelIndices;
+};
+
+/*
+Preprocessing of 8-bit grayscale pixels. One pass counts 256-bin histogram, amount of distinct gray levels is taken
+from it. Quantization to any amount of gray levels is a lookup table applied to rows of pixels, several amounts of gray
+levels are produced in one pass over the source pixels.
+*/
+class GrayLevelQuantizer {
+private:
+	cv::Mat _pixels;
+	std::array<unsigned long long, HISTOGRAM_BINS_AMOUNT> _histogram;
+
+	void calculateHistogram();
+	static cv::Mat createPixelTable(int grayLevelsAmount);
+	static cv::Mat createLevelIndexTable(int grayLevelsAmount);
+
+public:
+	GrayLevelQuantizer(cv::Mat pixels);
+
+	static void quantize(const cv::Mat& pixels, int grayLevelsAmount, cv::Mat& quantizedPixels, cv::Mat& levelIndices);
+	std::vector<QuantizedPixels> quantize(const std::vector<int>& grayLevelsAmounts);
+
+	unsigned int countGrayLevels();
+	std::array<unsigned long long, HISTOGRAM_BINS_AMOUNT> getHistogram();
+};
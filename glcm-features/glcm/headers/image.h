@@ -2,9 +2,15 @@
 
 #define MAX_PIXEL_VALUE 256
 #define DEFAULT_GRAY_LEVELS_AMOUNT 8
+// memory for pair code images of all images alive at once, offsets over it are counted without them
+#define DEFAULT_PAIR_CODES_MEMORY_BUDGET (1024ULL * 1024 * 1024)
 
 #include "../headers/image.h"
 #include "../headers/imageInfo.h"
+#include "../headers/stripWriter.h"
+#include "../headers/mappedRaster.h"
+#include "../headers/instrumentation.h"
+#include "../headers/grayLevelQuantizer.h"
 #include "../exceptions/ImageNotFoundException.h"
 #include "../exceptions/BadGrayLevels.h"
 
@@ -15,31 +21,62 @@
 #include <cstdlib>
 #include <filesystem>
 #include <set>
+#include <map>
+#include <vector>
+#include <mutex>
+#include <atomic>
 #include <opencv2/opencv.hpp>
 
+enum FeatureImageFormat {
+	FLOAT_TIFF,
+	FLOAT_NPY,
+	QUANTIZED_GRAY_LEVELS,
+	STACKED_TIFF,
+	STACKED_NPY
+};
+
 class Image {
 private:
 	std::string _path;
 	cv::Mat _img;
+	cv::Mat _levelIndices;
 	ImageInfo _imageInfo;
+	std::shared_ptr<MappedRaster> _raster;
+	std::once_flag _levelIndicesFlag;
+	std::map<std::pair<int, int>, cv::Mat> _pairCodes;
+	unsigned long long _pairCodesMemorySize;
+	std::mutex _pairCodesMutex;
+	static std::atomic<unsigned long long> _allPairCodesMemorySize;
 
 	bool isGrayLevelsAmountCorrect(int grayLevelsAmount);
 	bool isImageSizesCorrect(int width, int height);
+	void setGrayLevelsAmount(int grayLevelsAmount);
 	void loadImageInGrayScale();
 	void calculateOriginalGrayLevelsAmount();
 	void reduceGrayLevels();
+	void calculateGrayLevels();
+	void reduceMappedGrayLevels();
+	cv::Mat calculatePairCodeImage(std::pair<int, int> offset);
 	bool isGrayLevelCorrect();
 	bool isPixelCoordsCorrect(int i, int j);
 	int convertDoubleValueToGrayScale(double value);
 	int convertIntValueToGrayLevel(int value);
+	unsigned int readPixelValue(int i, int j);
+	bool saveNpy();
+	bool saveEncoded();
 
 public:
 	Image(std::string path, int grayLevelsAmount);
-	Image(std::shared_ptr<Image> image);
+	Image(std::string path, cv::Mat pixels, int grayLevelsAmount, unsigned int originalGrayLevelsAmount);
+	Image(std::string path, QuantizedPixels quantizedPixels, unsigned int originalGrayLevelsAmount);
+	Image(std::shared_ptr<Image> image, int matType = CV_32FC1);
+	Image(std::shared_ptr<MappedRaster> raster, int grayLevelsAmount);
+	~Image();
 
 	void setPixelValue(int i, int j, int value);
 	void setPixelValue(int i, int j, double value);
 
+	void quantizeToGrayLevels();
 	void saveImage();
 
 	void displayImage();
@@ -47,7 +84,10 @@ public:
 
 	ImageInfo getImageInfo();
 	cv::Mat getImage();
+	cv::Mat getLevelIndexImage();
+	cv::Mat getPairCodeImage(std::pair<int, int> offset);
 	std::string getPath();
 
 	void setImageName(std::string name);
+	void setExtension(std::string extension);
 };
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <array>
+#include <chrono>
+#include <mutex>
+#include <filesystem>
+#include <algorithm>
+
+enum InstrumentedStage {
+	STAGE_LOAD_IMAGE,
+	STAGE_REDUCE_GRAY_LEVELS,
+	STAGE_GLCM_ACCUMULATION,
+	STAGE_FEATURE_EVALUATION,
+	STAGE_SAVE_IMAGE,
+	STAGES_AMOUNT
+};
+
+enum InstrumentedCounter {
+	COUNTER_WINDOWS,
+	COUNTER_PAIRS,
+	COUNTER_BYTES_WRITTEN,
+	COUNTERS_AMOUNT
+};
+
+struct InstrumentationTotals {
+	std::array<unsigned long long, STAGES_AMOUNT> stageNs;
+	std::array<unsigned long long, STAGES_AMOUNT> stageCalls;
+	std::array<unsigned long long, COUNTERS_AMOUNT> counters;
+};
+
+/*
+Per-stage wall times and counters of processed windows, pairs and written bytes. Every thread collects into its own
+totals without synchronization, they are merged into process totals when the thread ends or a report is made.
+Times of stages are summed over threads, so with more threads they can exceed wall time of the run. Stages timed
+inside another stage are not counted twice, the outer stage gets only its own time.
+Use GLCM_* macros below, they are removed when library is built without GLCM_INSTRUMENTATION.
+*/
+class Instrumentation {
+private:
+	struct ThreadTotals {
+		InstrumentationTotals totals{};
+		~ThreadTotals();
+	};
+
+	static std::mutex _mutex;
+	static InstrumentationTotals _totals;
+
+	static InstrumentationTotals& threadTotals();
+	static void merge(InstrumentationTotals& totals);
+	static std::string stringifyStage(InstrumentedStage stage);
+
+public:
+	static void addStageTime(InstrumentedStage stage, unsigned long long ns);
+	static void addCount(InstrumentedCounter counter, unsigned long long amount);
+	static void addFileSize(std::string path);
+	static unsigned long long threadStagesTime();
+	static InstrumentationTotals collect();
+	static void reset();
+	static std::string report();
+};
+
+/*
+Measures time from its creation to the end of the scope and adds it to the stage, without time of stages timed inside
+the scope by the same thread. Loops can be timed once per row around per-window timers of other stages.
+*/
+class StageTimer {
+private:
+	InstrumentedStage _stage;
+	std::chrono::steady_clock::time_point _start;
+	unsigned long long _nestedStart;
+
+public:
+	StageTimer(InstrumentedStage stage);
+	~StageTimer();
+};
+
+#define GLCM_CONCAT_NAMES(first, second) first##second
+#define GLCM_UNIQUE_NAME(name, line) GLCM_CONCAT_NAMES(name, line)
+
+#ifdef GLCM_INSTRUMENTATION
+#define GLCM_TIME_STAGE(stage) StageTimer GLCM_UNIQUE_NAME(stageTimer, __LINE__)(stage)
+#define GLCM_COUNT(counter, amount) Instrumentation::addCount(counter, amount)
+#define GLCM_COUNT_FILE_BYTES(path) Instrumentation::addFileSize(path)
+#define GLCM_REPORT(stream) stream << Instrumentation::report()
+#else
+#define GLCM_TIME_STAGE(stage)
+#define GLCM_COUNT(counter, amount)
+#define GLCM_COUNT_FILE_BYTES(path)
+#define GLCM_REPORT(stream)
+#endif
@@ -0,0 +1,61 @@
+#pragma once
+
+#define DEFAULT_INTEGRAL_MEMORY_BUDGET (512ULL * 1024 * 1024)
+
+#include "../headers/glcm.h"
+#include "../headers/image.h"
+#include "../headers/glcmView.h"
+#include "../exceptions/BadRegion.h"
+
+#include <iostream>
+#include <vector>
+#include <utility>
+#include <tuple>
+#include <cstdint>
+#include <opencv2/opencv.hpp>
+
+/*
+Integral co-occurrence histograms. For every offset and every pair code (GLCM cell, or sum and difference histogram bins)
+keeps amount of pairs with first pixel above and left of every point of the image. GLCM of any rectangle is then
+calculated with four lookups per code, independently of rectangle size. Memory grows with L^2 for FULL_MATRIX storage,
+so it fits small amounts of gray levels. Integral can be built only for a strip of rows to bound memory.
+*/
+class IntegralGLCM {
+private:
+	std::shared_ptr<Image> _image;
+	std::vector<std::pair<int, int>> _offsets;
+	GLCMStorage _storage;
+	bool _horizontal;
+	unsigned int _size;
+	unsigned int _codesAmount;
+	int _firstRow;
+	int _lastRow;
+	int _width;
+	std::vector<uint32_t> _integral;
+
+	std::vector<unsigned long long> _glcm;
+	unsigned long long _pairsAmount;
+	std::vector<unsigned long long> _offsetWeights;
+	int _weightsHeight;
+	int _weightsWidth;
+	unsigned long long _weightedPairsAmount;
+
+	void buildIntegral();
+	unsigned int pairCode(int current, int neighbour);
+	const uint32_t* integralAt(int offsetIndex, int row, int col);
+	void addSymmetricCounts();
+
+public:
+	IntegralGLCM(std::shared_ptr<Image> image, const std::vector<std::pair<int, int>>& offsets, GLCMStorage storage = FULL_MATRIX, bool horizontal = true);
+	IntegralGLCM(std::shared_ptr<Image> image, const std::vector<std::pair<int, int>>& offsets, int firstRow, int lastRow, GLCMStorage storage = FULL_MATRIX, bool horizontal = true);
+
+	static unsigned long long calcRowMemorySize(unsigned int width, unsigned int grayLevelsAmount, unsigned int offsetsAmount, GLCMStorage storage);
+
+	void calculateGLCM(int top, int left, int windowSize);
+	void calculateGLCM(int top, int left, int height, int width);
+
+	GLCMView getGLCM();
+	SumDiffView getSumDiffHistograms();
+	int getFirstRow();
+	int getLastRow();
+};
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "../exceptions/BadRasterFile.h"
+
+#include <iostream>
+#include <string>
+#include <cctype>
+#include <climits>
+#include <algorithm>
+#include <opencv2/opencv.hpp>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/*
+Read-only memory mapping of single band raster file - binary PGM ("P5") or headerless raw 8-bit or 16-bit data.
+Pixels are wrapped in cv::Mat without copying, pages are loaded by the system when they are touched.
+*/
+class MappedRaster {
+private:
+	std::string _path;
+	const uchar* _mapping;
+	unsigned long long _mappingSize;
+#ifdef _WIN32
+	HANDLE _fileHandle;
+	HANDLE _mappingHandle;
+#else
+	int _fileDescriptor;
+#endif
+	unsigned int _width;
+	unsigned int _height;
+	unsigned int _bitDepth;
+	unsigned int _maxValue;
+	unsigned long long _dataOffset;
+	bool _bigEndian;
+
+	void mapFile();
+	void unmapFile();
+	bool parsePgmHeader();
+	bool parsePgmNumber(unsigned long long& position, unsigned int& number);
+	void checkDataSize();
+
+public:
+	MappedRaster(std::string path);
+	MappedRaster(std::string path, unsigned int width, unsigned int height, unsigned int bitDepth, unsigned long long dataOffset = 0);
+	~MappedRaster();
+	MappedRaster(const MappedRaster&) = delete;
+	MappedRaster& operator=(const MappedRaster&) = delete;
+
+	cv::Mat getPixels();
+	std::string getPath();
+	unsigned int getWidth();
+	unsigned int getHeight();
+	unsigned int getBitDepth();
+	unsigned int getMaxValue();
+	bool isBigEndian();
+};
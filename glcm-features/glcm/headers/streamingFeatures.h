@@ -0,0 +1,55 @@
+#pragma once
+
+#define DEFAULT_MEMORY_BUDGET (256ULL * 1024 * 1024)
+
+#include "../headers/glcm_features.h"
+#include "../headers/image.h"
+#include "../headers/stripReader.h"
+#include "../headers/stripWriter.h"
+
+#include <iostream>
+#include <filesystem>
+#include <memory>
+#include <vector>
+#include <set>
+#include <utility>
+#include <algorithm>
+
+/*
+Calculates feature images of rasters too big to be kept in memory. Image is read in horizontal strips with halo of
+windowSize rows, features of every strip are calculated with GLCM_features and written to disk before next strip is read.
+Results are identical to calculating whole image at once.
+*/
+class StreamingGLCMFeatures {
+private:
+	std::unique_ptr<StripReader> _reader;
+	int _grayLevelsAmount;
+	unsigned int _originalGrayLevelsAmount;
+	unsigned int _windowSize;
+	unsigned long long _memoryBudget;
+	ComputationMode _computationMode;
+	unsigned int _threadsAmount;
+	GLCMStorage _storage;
+	SimdLevel _simdLevel;
+	FeatureImageFormat _outputFormat;
+
+	void validWindowSize(unsigned int windowSize);
+	int calcStripRowsAmount(int featuresAmount, int offsetsAmount);
+	std::unique_ptr<GLCM_features> createStripFeatures(int firstRow, int lastRow);
+	std::vector<std::unique_ptr<Image>> calcStripFeatureMaps(std::unique_ptr<GLCM_features>& stripFeatures, std::vector<std::pair<int, int>>& offsets, std::set<FeatureType>& featureTypes, bool meanGLCM);
+	void calcFeatureStrips(std::vector<std::pair<int, int>> offsets, std::set<FeatureType> featureTypes, bool meanGLCM);
+	std::unique_ptr<StripWriter> createWriter(std::unique_ptr<Image>& featureMap);
+
+public:
+	StreamingGLCMFeatures(std::string path, int grayLevelsAmount, unsigned int windowSize = DEFAULT_WINDOW_SIZE, unsigned long long memoryBudget = DEFAULT_MEMORY_BUDGET);
+
+	void setMemoryBudget(unsigned long long memoryBudget);
+	void setComputationMode(ComputationMode computationMode);
+	void setThreadsAmount(unsigned int threadsAmount);
+	void setSimdLevel(SimdLevel simdLevel);
+	void setGLCMStorage(GLCMStorage storage);
+	void setOutputFormat(FeatureImageFormat outputFormat);
+
+	void features(std::pair<int, int> offset, std::set<FeatureType> featureTypes);
+	void features(std::vector<std::pair<int, int>> offsets, std::set<FeatureType> featureTypes);
+};
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "../headers/instrumentation.h"
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cctype>
+#include <algorithm>
+#include <opencv2/opencv.hpp>
+
+/*
+Reads grayscale image strip by strip. Binary 8-bit PGM files are read straight from disk, only requested rows are kept
+in memory. Other formats can't be read partially, so they are loaded whole with OpenCV and strips are cut from memory.
+*/
+class StripReader {
+private:
+	std::string _path;
+	std::ifstream _file;
+	std::streamoff _dataOffset;
+	int _width;
+	int _height;
+	bool _streamed;
+	cv::Mat _wholeImage;
+
+	bool readPgmHeader();
+	bool readPgmNumber(int& number);
+
+public:
+	StripReader(std::string path);
+
+	cv::Mat readRows(int firstRow, int lastRow);
+	unsigned int countGrayLevels();
+
+	int getWidth();
+	int getHeight();
+	std::string getPath();
+	bool isStreamed();
+};
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "../headers/instrumentation.h"
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <algorithm>
+#include <opencv2/opencv.hpp>
+
+/*
+Writes image to disk strip by strip, so whole image never has to be kept in memory.
+Float images (CV_32FC1) are written as NumPy .npy files, 8-bit images (CV_8UC1) as binary PGM files.
+Several float bands of the same size can be written one after another into one (bands, rows, cols) .npy file.
+*/
+class StripWriter {
+private:
+	std::ofstream _file;
+	int _rows;
+	int _cols;
+	int _matType;
+	int _bandsAmount;
+	int _writtenRows;
+
+	void writeNpyHeader();
+	void writePgmHeader();
+
+public:
+	StripWriter(std::string path, int rows, int cols, int matType, int bandsAmount = 1);
+
+	void writeRows(const cv::Mat& strip, int firstRow, int lastRow);
+	void writeZeroRows(int rowsAmount);
+	bool isComplete();
+	bool isGood();
+};
@@ -0,0 +1,495 @@
+#include "../headers/batchRunner.h"
+
+/**
+Read batch config. Every line is "key = value", lines starting with '#' are comments. Keys:
+	image - path to image, may be repeated
+	grayLevels - list of gray levels amounts, e.g. "8 16 32"
+	windowSizes - list of positive odd window sizes, e.g. "5 7 9", repeated sizes are calculated once
+	offsets - list of offsets, e.g. "(1,0) (0,1) (1,1) (-1,1)"
+	features - list of features: energy, entropy, contrast, homogeneity
+	meanGLCM - "true" calculates mean GLCM of all offsets, "false" calculates every offset separately
+	threads - amount of threads, 0 means amount of hardware threads
+	encoders - amount of threads saving feature images besides computing threads
+	computationMode - "sliding", "bruteForce", "integral" or "columns"
+	storage - "full", "sparse" or "sumDiff", "full" switches to sparse GLCM by itself where it pays off
+	outputFormat - "tiff", "npy", "quantized", "stackedTiff" or "stackedNpy", stacked formats save all features
+		of one image into one multi-band file
+	compression - "none", "lzw" or "deflate", compression of "stackedTiff" pages
+@param configPath - path to config file.
+*/
+BatchRunner::BatchRunner(std::string configPath) {
+	this->_configPath = configPath;
+	this->_meanGLCM = true;
+	this->_threadsAmount = 0;
+	this->_encodersAmount = DEFAULT_ENCODERS_AMOUNT;
+	this->_computationMode = SLIDING_WINDOW;
+	this->_storage = FULL_MATRIX;
+	this->_outputFormat = FLOAT_TIFF;
+	this->_compression = STACK_UNCOMPRESSED;
+	this->parseConfig();
+}
+
+void BatchRunner::parseConfig() {
+	std::ifstream configFile(this->_configPath);
+	if (!configFile) {
+		throw new BadConfig(this->_configPath, "can't open file");
+	}
+
+	std::string line;
+	int lineNumber = 0;
+	while (std::getline(configFile, line)) {
+		lineNumber++;
+		line = line.substr(0, line.find('#'));
+		if (line.find_first_not_of(" \t\r") == std::string::npos) {
+			continue;
+		}
+
+		size_t separator = line.find('=');
+		if (separator == std::string::npos) {
+			throw new BadConfig(this->_configPath, "missing '=' in line " + std::to_string(lineNumber));
+		}
+
+		std::vector<std::string> key = this->splitValues(line.substr(0, separator));
+		std::string value = line.substr(separator + 1);
+		value.erase(0, value.find_first_not_of(" \t"));
+		value.erase(value.find_last_not_of(" \t\r") + 1);
+		if (key.size() != 1 || value.empty()) {
+			throw new BadConfig(this->_configPath, "wrong entry in line " + std::to_string(lineNumber));
+		}
+		this->parseConfigEntry(key[0], value, lineNumber);
+	}
+
+	if (this->_imagePaths.empty() || this->_grayLevels.empty() || this->_windowSizes.empty() ||
+		this->_offsets.empty() || this->_featureTypes.empty()) {
+		throw new BadConfig(this->_configPath, "image, grayLevels, windowSizes, offsets and features are required");
+	}
+
+	// the same order and sizes as GLCM_features uses, so bands of stacked output match its feature images
+	std::sort(this->_windowSizes.begin(), this->_windowSizes.end());
+	this->_windowSizes.erase(std::unique(this->_windowSizes.begin(), this->_windowSizes.end()), this->_windowSizes.end());
+}
+
+void BatchRunner::parseConfigEntry(std::string key, std::string value, int lineNumber) {
+	std::string lineAsString = " in line " + std::to_string(lineNumber);
+	try {
+		if (key == "image") {
+			this->_imagePaths.push_back(value);
+		}
+		else if (key == "grayLevels") {
+			for (auto grayLevel : this->splitValues(value)) {
+				int grayLevelsAmount = std::stoi(grayLevel);
+				if (grayLevelsAmount <= 0 || grayLevelsAmount >= 256) {
+					throw new BadConfig(this->_configPath, "gray levels amounts have to be within (0, 255>");
+				}
+				this->_grayLevels.push_back(grayLevelsAmount);
+			}
+		}
+		else if (key == "windowSizes") {
+			for (auto windowSize : this->splitValues(value)) {
+				unsigned int windowSizeValue = static_cast<unsigned int>(std::stoul(windowSize));
+				if (windowSizeValue % 2 == 0) {
+					throw new BadConfig(this->_configPath, "window sizes have to be positive odd numbers" + lineAsString);
+				}
+				this->_windowSizes.push_back(windowSizeValue);
+			}
+		}
+		else if (key == "offsets") {
+			std::regex offsetPattern("\\(\\s*(-?\\d+)\\s*,\\s*(-?\\d+)\\s*\\)");
+			// only whitespace may be left between offsets, anything else is a misspelled offset
+			std::string unmatched;
+			std::string rest = value;
+			for (auto it = std::sregex_iterator(value.begin(), value.end(), offsetPattern); it != std::sregex_iterator(); ++it) {
+				unmatched += it->prefix().str();
+				rest = it->suffix().str();
+				this->_offsets.push_back(std::pair<int, int>(std::stoi((*it)[1]), std::stoi((*it)[2])));
+			}
+			unmatched += rest;
+			if (!this->splitValues(unmatched).empty()) {
+				throw new BadConfig(this->_configPath, "wrong offsets " + value + lineAsString);
+			}
+		}
+		else if (key == "features") {
+			for (auto feature : this->splitValues(value)) {
+				if (feature == "energy") {
+					this->_featureTypes.insert(ENERGY);
+				}
+				else if (feature == "entropy") {
+					this->_featureTypes.insert(ENTROPY);
+				}
+				else if (feature == "contrast") {
+					this->_featureTypes.insert(CONTRAST);
+				}
+				else if (feature == "homogeneity") {
+					this->_featureTypes.insert(HOMOGENEITY);
+				}
+				else {
+					throw new BadConfig(this->_configPath, "unknown feature " + feature + lineAsString);
+				}
+			}
+		}
+		else if (key == "meanGLCM") {
+			if (value != "true" && value != "false") {
+				throw new BadConfig(this->_configPath, "meanGLCM has to be true or false" + lineAsString);
+			}
+			this->_meanGLCM = value == "true";
+		}
+		else if (key == "threads") {
+			this->_threadsAmount = static_cast<unsigned int>(std::stoul(value));
+		}
+		else if (key == "encoders") {
+			this->_encodersAmount = std::max(1u, static_cast<unsigned int>(std::stoul(value)));
+		}
+		else if (key == "computationMode") {
+			if (value == "bruteForce") {
+				this->_computationMode = BRUTE_FORCE;
+			}
+			else if (value == "integral") {
+				this->_computationMode = INTEGRAL_HISTOGRAMS;
+			}
+			else if (value == "columns") {
+				this->_computationMode = COLUMN_HISTOGRAMS;
+			}
+			else if (value == "sliding") {
+				this->_computationMode = SLIDING_WINDOW;
+			}
+			else {
+				throw new BadConfig(this->_configPath, "unknown computation mode " + value + lineAsString);
+			}
+		}
+		else if (key == "storage") {
+			if (value == "sumDiff") {
+				this->_storage = SUM_DIFF_HISTOGRAMS;
+			}
+			else if (value == "sparse") {
+				this->_storage = SPARSE_MATRIX;
+			}
+			else if (value == "full") {
+				this->_storage = FULL_MATRIX;
+			}
+			else {
+				throw new BadConfig(this->_configPath, "unknown storage " + value + lineAsString);
+			}
+		}
+		else if (key == "outputFormat") {
+			if (value == "tiff") {
+				this->_outputFormat = FLOAT_TIFF;
+			}
+			else if (value == "npy") {
+				this->_outputFormat = FLOAT_NPY;
+			}
+			else if (value == "quantized") {
+				this->_outputFormat = QUANTIZED_GRAY_LEVELS;
+			}
+			else if (value == "stackedTiff") {
+				this->_outputFormat = STACKED_TIFF;
+			}
+			else if (value == "stackedNpy") {
+				this->_outputFormat = STACKED_NPY;
+			}
+			else {
+				throw new BadConfig(this->_configPath, "unknown output format " + value + lineAsString);
+			}
+		}
+		else if (key == "compression") {
+			if (value == "none") {
+				this->_compression = STACK_UNCOMPRESSED;
+			}
+			else if (value == "lzw") {
+				this->_compression = STACK_LZW;
+			}
+			else if (value == "deflate") {
+				this->_compression = STACK_DEFLATE;
+			}
+			else {
+				throw new BadConfig(this->_configPath, "unknown compression " + value + lineAsString);
+			}
+		}
+		else {
+			throw new BadConfig(this->_configPath, "unknown key " + key + lineAsString);
+		}
+	}
+	catch (std::logic_error&) {
+		throw new BadConfig(this->_configPath, "wrong number" + lineAsString);
+	}
+}
+
+std::vector<std::string> BatchRunner::splitValues(std::string value) {
+	std::vector<std::string> values;
+	std::stringstream valueStream(value);
+	std::string singleValue;
+	while (valueStream >> singleValue) {
+		values.push_back(singleValue);
+	}
+
+	return values;
+}
+
+/**
+Calculate all features of all configured images. Work is pipelined: decoder thread loads and quantizes the next image
+while jobs of the current one run in parallel, compute workers hand feature images over to encoder threads and go on.
+Queues between stages are bounded, so memory stays capped when one stage is slower than the others.
+Total throughput is printed at the end.
+*/
+void BatchRunner::run() {
+	unsigned int threadsAmount = this->_threadsAmount == 0 ? std::max(1u, std::thread::hardware_concurrency()) : this->_threadsAmount;
+	unsigned long long windowsAmount = 0;
+	unsigned long long jobsAmount = 0;
+
+	auto start = std::chrono::steady_clock::now();
+	BoundedQueue<PrefetchedImage> prefetchedImages(DEFAULT_PREFETCHED_IMAGES);
+	BoundedQueue<EncodeTask> encodeTasks(DEFAULT_ENCODE_QUEUE_SIZE);
+	std::thread decoder([this, &prefetchedImages]() {
+		this->decodeImages(prefetchedImages);
+	});
+	std::vector<std::thread> encoders;
+	std::vector<std::exception_ptr> errors(this->_encodersAmount + 1);
+	for (unsigned int e = 0; e < this->_encodersAmount; e++) {
+		encoders.emplace_back([this, &encodeTasks, &errors, e]() {
+			this->encodeImages(encodeTasks, errors[e + 1]);
+		});
+	}
+
+	try {
+		PrefetchedImage prefetchedImage;
+		while (prefetchedImages.pop(prefetchedImage)) {
+			if (prefetchedImage.error) {
+				std::rethrow_exception(prefetchedImage.error);
+			}
+
+			std::vector<BatchJob> jobs = this->createJobs(prefetchedImage.images);
+			std::shared_ptr<FeatureStack> featureStack;
+			if (this->isOutputStacked()) {
+				size_t bandsAmount = jobs.size() * this->_windowSizes.size() * this->_featureTypes.size();
+				std::string imageName = std::filesystem::path(prefetchedImage.path).filename().replace_extension("").string();
+				featureStack = std::make_shared<FeatureStack>(imageName + "_features", bandsAmount, this->_compression);
+			}
+			this->runJobs(jobs, encodeTasks, featureStack);
+			if (featureStack) {
+				encodeTasks.push(EncodeTask{ nullptr, featureStack });
+			}
+			prefetchedImage.images.clear();
+
+			for (auto& job : jobs) {
+				windowsAmount += job.windowsAmount;
+			}
+			jobsAmount += jobs.size();
+		}
+	}
+	catch (...) {
+		errors[0] = std::current_exception();
+	}
+
+	// encoders save all queued images before they stop
+	prefetchedImages.close();
+	encodeTasks.close();
+	decoder.join();
+	for (auto& encoder : encoders) {
+		encoder.join();
+	}
+	for (auto& error : errors) {
+		if (error) {
+			std::rethrow_exception(error);
+		}
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::cout << "Batch finished: " << jobsAmount << " jobs, " << windowsAmount << " windows, "
+		<< windowsAmount * this->_featureTypes.size() << " feature values in " << seconds << " s on " << threadsAmount << " threads ("
+		<< (seconds > 0 ? windowsAmount / seconds : 0) << " windows/s)" << std::endl;
+	GLCM_REPORT(std::cout << "Run report: ");
+}
+
+/*
+Decoder stage. Images are loaded in config order, loading stops at the first error, which is passed to compute stage.
+*/
+void BatchRunner::decodeImages(BoundedQueue<PrefetchedImage>& prefetchedImages) {
+	for (auto imagePath : this->_imagePaths) {
+		PrefetchedImage prefetchedImage;
+		prefetchedImage.path = imagePath;
+		try {
+			prefetchedImage.images = this->loadQuantizedImages(imagePath);
+		}
+		catch (...) {
+			prefetchedImage.error = std::current_exception();
+		}
+
+		bool failed = static_cast<bool>(prefetchedImage.error);
+		if (!prefetchedImages.push(std::move(prefetchedImage)) || failed) {
+			break;
+		}
+	}
+	prefetchedImages.close();
+}
+
+/*
+Encoder stage. Saves feature images and stacks until the queue is closed and empty. After an error the rest of images is still
+taken from the queue, so compute workers never wait for a stopped encoder.
+*/
+void BatchRunner::encodeImages(BoundedQueue<EncodeTask>& encodeTasks, std::exception_ptr& error) {
+	EncodeTask encodeTask;
+	while (encodeTasks.pop(encodeTask)) {
+		try {
+			if (encodeTask.featureStack) {
+				encodeTask.featureStack->save(this->_outputFormat);
+			}
+			else {
+				GLCM_features::saveFeatureImage(encodeTask.featureImage, this->_outputFormat);
+			}
+		}
+		catch (...) {
+			if (!error) {
+				error = std::current_exception();
+			}
+		}
+		encodeTask = EncodeTask();
+	}
+}
+
+bool BatchRunner::isOutputStacked() {
+	return this->_outputFormat == STACKED_TIFF || this->_outputFormat == STACKED_NPY;
+}
+
+/*
+Decode image once, count its histogram once and quantize it to all gray levels amounts in one pass over decoded pixels.
+*/
+std::vector<std::shared_ptr<Image>> BatchRunner::loadQuantizedImages(std::string path) {
+	cv::Mat pixels;
+	{
+		GLCM_TIME_STAGE(STAGE_LOAD_IMAGE);
+		pixels = cv::imread(path, cv::IMREAD_GRAYSCALE);
+	}
+	if (pixels.empty()) {
+		std::cerr << "Error: Unable to load the image." << std::endl;
+		throw new ImageNotFoundException(path);
+	}
+
+	GrayLevelQuantizer quantizer(pixels);
+	unsigned int originalGrayLevelsAmount = quantizer.countGrayLevels();
+
+	std::vector<std::shared_ptr<Image>> images;
+	for (auto& quantizedPixels : quantizer.quantize(this->_grayLevels)) {
+		images.push_back(std::make_shared<Image>(path, quantizedPixels, originalGrayLevelsAmount));
+	}
+
+	return images;
+}
+
+/*
+Create one job per gray level and offset (or offsets set), all window sizes of a job share one traversal of the image.
+Jobs are sorted from the most expensive, so long jobs do not end up last on one thread. Bands of stacked output keep
+order of creation, every job has window sizes * features bands starting at firstBand.
+*/
+std::vector<BatchJob> BatchRunner::createJobs(std::vector<std::shared_ptr<Image>>& images) {
+	std::vector<std::vector<std::pair<int, int>>> offsetsSets;
+	if (this->_meanGLCM) {
+		offsetsSets.push_back(this->_offsets);
+	}
+	else {
+		for (auto offset : this->_offsets) {
+			offsetsSets.push_back({ offset });
+		}
+	}
+
+	std::vector<BatchJob> jobs;
+	for (auto& image : images) {
+		long long width = image->getImageInfo().width;
+		long long height = image->getImageInfo().height;
+		// GLCM_features would replace the size with default one and stacked output would miss bands
+		if (this->_windowSizes.back() > std::min(width, height)) {
+			throw new BadConfig(this->_configPath, "window size " + std::to_string(this->_windowSizes.back()) + " does not fit image " + image->getPath());
+		}
+		for (auto& offsets : offsetsSets) {
+			BatchJob job;
+			job.image = image;
+			job.windowSizes = this->_windowSizes;
+			job.offsets = offsets;
+			job.firstBand = jobs.size() * this->_windowSizes.size() * this->_featureTypes.size();
+			job.windowsAmount = 0;
+			job.cost = 0;
+			for (long long windowSize : this->_windowSizes) {
+				unsigned long long windowsAmount = static_cast<unsigned long long>(std::max(0LL, height - windowSize) * std::max(0LL, width - windowSize));
+				// sliding window updates cost O(windowSize) per window, recalculating GLCM costs O(windowSize^2),
+				// integral and column histograms cost the same for every window size
+				unsigned long long windowCost = windowSize * windowSize;
+				if (this->_computationMode == SLIDING_WINDOW) {
+					windowCost = windowSize;
+				}
+				else if (this->_computationMode == INTEGRAL_HISTOGRAMS || this->_computationMode == COLUMN_HISTOGRAMS) {
+					windowCost = 1;
+				}
+				job.windowsAmount += windowsAmount;
+				job.cost += windowsAmount * offsets.size() * windowCost;
+			}
+			jobs.push_back(job);
+		}
+	}
+
+	std::stable_sort(jobs.begin(), jobs.end(), [](const BatchJob& a, const BatchJob& b) { return a.cost > b.cost; });
+
+	return jobs;
+}
+
+/*
+Workers take jobs in order until none is left. When there are less jobs than threads, spare threads are split
+between jobs as row bands.
+*/
+void BatchRunner::runJobs(std::vector<BatchJob>& jobs, BoundedQueue<EncodeTask>& encodeTasks, std::shared_ptr<FeatureStack> featureStack) {
+	unsigned int threadsAmount = this->_threadsAmount == 0 ? std::max(1u, std::thread::hardware_concurrency()) : this->_threadsAmount;
+	unsigned int workersAmount = std::min<unsigned int>(threadsAmount, static_cast<unsigned int>(jobs.size()));
+	if (workersAmount == 0) {
+		return;
+	}
+	unsigned int threadsPerJob = threadsAmount / workersAmount;
+
+	std::atomic<size_t> nextJob(0);
+	std::vector<std::thread> workers;
+	std::vector<std::exception_ptr> errors(workersAmount);
+	for (unsigned int t = 0; t < workersAmount; t++) {
+		workers.emplace_back([this, &jobs, &encodeTasks, featureStack, &nextJob, &errors, t, threadsPerJob]() {
+			try {
+				for (size_t job = nextJob++; job < jobs.size(); job = nextJob++) {
+					this->runJob(jobs[job], threadsPerJob, encodeTasks, featureStack);
+				}
+			}
+			catch (...) {
+				errors[t] = std::current_exception();
+			}
+		});
+	}
+
+	for (auto& worker : workers) {
+		worker.join();
+	}
+
+	for (auto& error : errors) {
+		if (error) {
+			std::rethrow_exception(error);
+		}
+	}
+}
+
+/*
+Calculate feature images of the job and hand them over to encoders. Waits only when encoders are DEFAULT_ENCODE_QUEUE_SIZE
+images behind. With stacked output images are put into the stack of the input, it is saved when all jobs are done.
+*/
+void BatchRunner::runJob(BatchJob& job, unsigned int threadsAmount, BoundedQueue<EncodeTask>& encodeTasks, std::shared_ptr<FeatureStack> featureStack) {
+	std::unique_ptr<GLCM_features> glcmFeatures = std::make_unique<GLCM_features>(job.image, job.windowSizes, this->_computationMode);
+	glcmFeatures->setThreadsAmount(threadsAmount);
+	glcmFeatures->setGLCMStorage(this->_storage);
+	std::vector<std::unique_ptr<Image>> textureFeatureImages;
+	if (this->_meanGLCM) {
+		textureFeatureImages = glcmFeatures->featureMaps(job.offsets, this->_featureTypes);
+	}
+	else {
+		textureFeatureImages = glcmFeatures->featureMaps(job.offsets[0], this->_featureTypes);
+	}
+
+	for (size_t n = 0; n < textureFeatureImages.size(); n++) {
+		if (featureStack) {
+			featureStack->setBand(job.firstBand + n, textureFeatureImages[n]);
+		}
+		else {
+			encodeTasks.push(EncodeTask{ std::move(textureFeatureImages[n]), nullptr });
+		}
+	}
+}
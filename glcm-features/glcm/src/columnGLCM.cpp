@@ -0,0 +1,183 @@
+#include "../headers/columnGLCM.h"
+
+/**
+Create column histograms for windows of one size. Histograms are filled by the first startColumnGLCM().
+@param image - successfully loaded image from disk.
+@param offsets - vector of pairs representing offsets. Any non-zero (dx, dy).
+@param windowSize - size of square windows.
+@param storage - FULL_MATRIX gives GLCM, SUM_DIFF_HISTOGRAMS gives sum and difference histograms with much less memory.
+		SPARSE_MATRIX is kept as full matrix.
+*/
+ColumnGLCM::ColumnGLCM(std::shared_ptr<Image> image, const std::vector<std::pair<int, int>>& offsets, int windowSize, GLCMStorage storage) {
+	if (offsets.empty()) {
+		throw new NoOffsets();
+	}
+
+	for (auto offset : offsets) {
+		if (!GLCM::checkOffset(offset)) {
+			throw new BadOffset();
+		}
+	}
+
+	this->_image = image;
+	this->_levelIndices = this->_image->getLevelIndexImage();
+	this->_offsets = offsets;
+	this->_storage = storage;
+	this->_size = this->_image->getImageInfo().grayLevelsAmount;
+	this->_codesAmount = this->_storage == SUM_DIFF_HISTOGRAMS ? 2 * (2 * this->_size - 1) : this->_size * this->_size;
+	this->_width = this->_image->getImageInfo().width;
+	this->_windowSize = windowSize;
+	this->_columnHistograms = std::vector<uint32_t>(static_cast<size_t>(this->_width) * this->_offsets.size() * this->_codesAmount);
+	this->_histogramsTop = INT_MIN;
+
+	this->_glcm = std::vector<unsigned long long>(this->_codesAmount);
+	this->_pairsAmount = GLCM::calcOffsetWeights(this->_offsets, windowSize, windowSize, false, this->_offsetWeights);
+	this->_top = 0;
+	this->_left = 0;
+}
+
+/**
+Calculate memory needed by column histograms of one window size.
+@return Amount of bytes.
+*/
+unsigned long long ColumnGLCM::calcMemorySize(unsigned int width, unsigned int grayLevelsAmount, unsigned int offsetsAmount, GLCMStorage storage) {
+	unsigned long long codesAmount = storage == SUM_DIFF_HISTOGRAMS ? 2 * (2 * grayLevelsAmount - 1) : grayLevelsAmount * grayLevelsAmount;
+	return static_cast<unsigned long long>(width) * offsetsAmount * codesAmount * sizeof(uint32_t);
+}
+
+uint32_t* ColumnGLCM::columnHistogram(int offsetIndex, int col) {
+	size_t position = static_cast<size_t>(col) * this->_offsets.size() + offsetIndex;
+	return this->_columnHistograms.data() + position * this->_codesAmount;
+}
+
+/*
+Add pairs of one row to column histograms of offset. Weight can be negative in two's complement to remove the row.
+*/
+void ColumnGLCM::addHistogramsRow(int offsetIndex, int row, uint32_t weight) {
+	std::pair<int, int> offset = this->_offsets[offsetIndex];
+	int firstCol = std::max(0, -offset.first);
+	int lastCol = this->_width - std::max(0, offset.first);
+	const uchar* currentRow = this->_levelIndices.ptr<uchar>(row);
+	const uchar* neighbourRow = this->_levelIndices.ptr<uchar>(row + offset.second) + offset.first;
+	// centered, so it can be indexed with negative differences
+	unsigned int differenceCenter = (2 * this->_size - 1) + (this->_size - 1);
+	for (int col = firstCol; col < lastCol; col++) {
+		uint32_t* histogram = this->columnHistogram(offsetIndex, col);
+		int current = currentRow[col];
+		int neighbour = neighbourRow[col];
+		if (this->_storage == SUM_DIFF_HISTOGRAMS) {
+			histogram[current + neighbour] += weight;
+			histogram[differenceCenter + current - neighbour] += weight;
+		}
+		else {
+			histogram[current * this->_size + neighbour] += weight;
+		}
+	}
+	GLCM_COUNT(COUNTER_PAIRS, std::max(0, lastCol - firstCol));
+}
+
+/*
+Add column histogram of offset to GLCM. Weight can be negative in two's complement to remove the column.
+*/
+void ColumnGLCM::addColumn(int offsetIndex, int col, unsigned long long weight) {
+	const uint32_t* histogram = this->columnHistogram(offsetIndex, col);
+	unsigned long long* glcm = this->_glcm.data();
+	for (unsigned int n = 0; n < this->_codesAmount; n++) {
+		glcm[n] += weight * histogram[n];
+	}
+}
+
+/*
+Move column histograms to rows of windows with given top. Next row is reached by removing the row leaving the window
+and adding the entering one, other rows are filled from scratch.
+*/
+void ColumnGLCM::moveHistograms(int top) {
+	for (int k = 0; k < this->_offsets.size(); k++) {
+		if (this->_offsetWeights[k] == 0) {
+			continue;
+		}
+
+		auto [firstRow, lastRow, firstCol, lastCol] = GLCM::getPairsRange(this->_offsets[k], top, 0, this->_windowSize, this->_width);
+		if (top == this->_histogramsTop + 1) {
+			this->addHistogramsRow(k, firstRow - 1, static_cast<uint32_t>(-1));
+			this->addHistogramsRow(k, lastRow - 1, 1);
+		}
+		else {
+			for (int col = 0; col < this->_width; col++) {
+				uint32_t* histogram = this->columnHistogram(k, col);
+				std::fill(histogram, histogram + this->_codesAmount, 0);
+			}
+			for (int row = firstRow; row < lastRow; row++) {
+				this->addHistogramsRow(k, row, 1);
+			}
+		}
+	}
+	this->_histogramsTop = top;
+}
+
+/**
+Calculate GLCM (mean GLCM for more offsets) of the window from column histograms. Windows should go down the image
+row by row, so column histograms are only moved by one row.
+@param top - row index of left top element of window
+@param left - column index of left top element of window
+*/
+void ColumnGLCM::startColumnGLCM(int top, int left) {
+	GLCM_TIME_STAGE(STAGE_GLCM_ACCUMULATION);
+	if (top != this->_histogramsTop) {
+		this->moveHistograms(top);
+	}
+
+	std::fill(this->_glcm.begin(), this->_glcm.end(), 0);
+	for (int k = 0; k < this->_offsets.size(); k++) {
+		if (this->_offsetWeights[k] == 0) {
+			continue;
+		}
+
+		auto [firstRow, lastRow, firstCol, lastCol] = GLCM::getPairsRange(this->_offsets[k], top, left, this->_windowSize, this->_windowSize);
+		for (int col = firstCol; col < lastCol; col++) {
+			this->addColumn(k, col, this->_offsetWeights[k]);
+		}
+	}
+	this->_top = top;
+	this->_left = left;
+}
+
+/**
+Move window one column right by adding histogram of the entering column and subtracting histogram of the leaving one.
+Not timed, slides are timed per row by the caller.
+*/
+void ColumnGLCM::slideGLCMRight() {
+	for (int k = 0; k < this->_offsets.size(); k++) {
+		unsigned long long weight = this->_offsetWeights[k];
+		if (weight == 0) {
+			continue;
+		}
+
+		auto [firstRow, lastRow, firstCol, lastCol] = GLCM::getPairsRange(this->_offsets[k], this->_top, this->_left, this->_windowSize, this->_windowSize);
+		// unsigned wrap-around cancels out, counts stay exact
+		this->addColumn(k, firstCol, 0 - weight);
+		this->addColumn(k, lastCol, weight);
+	}
+	this->_left++;
+}
+
+/**
+Get view of calculated GLCM. View is valid until next calculation or destruction. For FULL_MATRIX and SPARSE_MATRIX storage.
+@return Contiguous size x size matrix of counts and their sum.
+*/
+GLCMView ColumnGLCM::getGLCM() {
+	return GLCMView{ this->_glcm.data(), this->_size, this->_pairsAmount };
+}
+
+/**
+Get view of calculated sum and difference histograms. View is valid until next calculation or destruction. Only for SUM_DIFF_HISTOGRAMS storage.
+@return Histograms with 2 * size - 1 bins and sum of counts of each of them.
+*/
+SumDiffView ColumnGLCM::getSumDiffHistograms() {
+	unsigned int binsAmount = 2 * this->_size - 1;
+	return SumDiffView{ this->_glcm.data(), this->_glcm.data() + binsAmount, this->_size, this->_pairsAmount };
+}
+
+GLCMStorage ColumnGLCM::getStorage() {
+	return this->_storage;
+}
@@ -0,0 +1,194 @@
+#include "../headers/featureKernels.h"
+
+#include <algorithm>
+
+/*
+Evaluate features of GLCM with any gray levels amount. Contrast and homogeneity use precomputed weights like fixed size
+and SIMD kernels, so all kernels multiply counts by the same values.
+@param glcm - view of GLCM counts.
+@param weights - contrast and homogeneity weights for GLCM size and entropy table.
+@param entropyNeeded - entropy is calculated only on demand.
+*/
+FeatureValues calcFeatureValuesGeneric(GLCMView glcm, const FeatureWeights& weights, bool entropyNeeded) {
+	double energy = 0.0;
+	double entropy = 0.0;
+	double contrast = 0.0;
+	double homogeneity = 0.0;
+	unsigned int cellsAmount = glcm.size * glcm.size;
+	for (unsigned int k = 0; k < cellsAmount; k++) {
+		if (glcm.counts[k] == 0) {
+			continue;
+		}
+
+		double count = static_cast<double>(glcm.counts[k]);
+		energy += count * count;
+		if (entropyNeeded) {
+			entropy += glcm.counts[k] < weights.countLogCount.size() ? weights.countLogCount[glcm.counts[k]] : count * std::log(count);
+		}
+		contrast += count * weights.contrast[k];
+		homogeneity += count * weights.homogeneity[k];
+	}
+
+	return normalizeFeatureSums(energy, entropy, contrast, homogeneity, glcm.pairsAmount);
+}
+
+/*
+Evaluate features of GLCM. SIMD kernels are used when CPU supports them, otherwise gray levels amounts 8, 16, 24 and 32
+use kernels specialized at compile time and other amounts use generic kernel.
+SIMD kernels sum in different order than scalar ones, results differ from scalar kernels by less than 1e-12 relative error.
+@param glcm - view of GLCM counts.
+@param weights - contrast and homogeneity weights for GLCM size and entropy table, see makeFeatureWeights() and makeCountLogCountTable().
+@param entropyNeeded - entropy is calculated only on demand.
+@param simdLevel - the widest instruction set allowed, see detectSimdLevel().
+*/
+FeatureValues calcFeatureValues(GLCMView glcm, const FeatureWeights& weights, bool entropyNeeded, SimdLevel simdLevel) {
+#ifdef GLCM_X86_KERNELS
+	if (glcm.pairsAmount < SIMD_MAX_PAIRS_AMOUNT) {
+		if (simdLevel == SIMD_AVX2) {
+			return calcFeatureValuesAvx2(glcm, weights, entropyNeeded);
+		}
+		if (simdLevel == SIMD_SSE2) {
+			return calcFeatureValuesSse2(glcm, weights, entropyNeeded);
+		}
+	}
+#endif
+
+	switch (glcm.size) {
+		case 8:
+			return calcFeatureValuesFixed<8>(glcm.counts, glcm.pairsAmount, weights.countLogCount, entropyNeeded);
+		case 16:
+			return calcFeatureValuesFixed<16>(glcm.counts, glcm.pairsAmount, weights.countLogCount, entropyNeeded);
+		case 24:
+			return calcFeatureValuesFixed<24>(glcm.counts, glcm.pairsAmount, weights.countLogCount, entropyNeeded);
+		case 32:
+			return calcFeatureValuesFixed<32>(glcm.counts, glcm.pairsAmount, weights.countLogCount, entropyNeeded);
+		default:
+			return calcFeatureValuesGeneric(glcm, weights, entropyNeeded);
+	}
+}
+
+/*
+Evaluate features over occupied cells of sparse GLCM only. Cells are visited in the same order and summed with the same
+expressions as in calcFeatureValuesGeneric(), so results are equal to it. Homogeneity uses the same reciprocal weights
+as full matrix kernels, so switching storage of a window to sparse does not change it.
+@param glcm - view of sparse GLCM.
+@param weights - contrast and homogeneity weights for GLCM size and entropy table.
+@param entropyNeeded - entropy is calculated only on demand.
+*/
+FeatureValues calcSparseFeatureValues(SparseGLCMView glcm, const FeatureWeights& weights, bool entropyNeeded) {
+	double energy = 0.0;
+	double entropy = 0.0;
+	double contrast = 0.0;
+	double homogeneity = 0.0;
+	for (unsigned int n = 0; n < glcm.occupiedAmount; n++) {
+		int code = glcm.occupiedCodes[n];
+		unsigned long long cellCount = glcm.counts[code];
+
+		double count = static_cast<double>(cellCount);
+		energy += count * count;
+		if (entropyNeeded) {
+			entropy += cellCount < weights.countLogCount.size() ? weights.countLogCount[cellCount] : count * std::log(count);
+		}
+		contrast += count * weights.contrast[code];
+		homogeneity += count * weights.homogeneity[code];
+	}
+
+	return normalizeFeatureSums(energy, entropy, contrast, homogeneity, glcm.pairsAmount);
+}
+
+/*
+Evaluate features from sum and difference histograms (Unser). Contrast and homogeneity depend only on i - j,
+so they are exact. Energy and entropy are approximations:
+energy = sum(Ps(k)^2) * sum(Pd(k)^2), entropy = -sum(Ps(k) * log(Ps(k))) - sum(Pd(k) * log(Pd(k))),
+where Ps and Pd are normalized sum and difference histograms.
+@param histograms - view of sum and difference histograms.
+@param weights - only entropy table is used.
+@param entropyNeeded - entropy is calculated only on demand.
+*/
+FeatureValues calcSumDiffFeatureValues(SumDiffView histograms, const FeatureWeights& weights, bool entropyNeeded) {
+	int binsAmount = 2 * histograms.size - 1;
+	int maxDifference = histograms.size - 1;
+	double sumEnergy = 0.0;
+	double differenceEnergy = 0.0;
+	double contrast = 0.0;
+	double homogeneity = 0.0;
+	for (int k = 0; k < binsAmount; k++) {
+		double sumCount = static_cast<double>(histograms.sumHistogram[k]);
+		double differenceCount = static_cast<double>(histograms.differenceHistogram[k]);
+		int difference = k - maxDifference;
+		sumEnergy += sumCount * sumCount;
+		differenceEnergy += differenceCount * differenceCount;
+		contrast += differenceCount * (difference * difference);
+		homogeneity += differenceCount / (1 + difference * difference);
+	}
+
+	double entropy = 0.0;
+	if (entropyNeeded) {
+		entropy = sumCountLogCount(histograms.sumHistogram, binsAmount, weights.countLogCount) +
+			sumCountLogCount(histograms.differenceHistogram, binsAmount, weights.countLogCount);
+	}
+
+	double total = static_cast<double>(histograms.pairsAmount);
+	FeatureValues values;
+	values.energy = sumEnergy / (total * total) * differenceEnergy / (total * total);
+	values.entropy = 2.0 * std::log(total) - entropy / total;
+	values.contrast = contrast / total;
+	values.homogeneity = homogeneity / total;
+
+	return values;
+}
+
+/*
+Precompute contrast and homogeneity weights of every cell of size x size GLCM.
+*/
+FeatureWeights makeFeatureWeights(unsigned int size) {
+	FeatureWeights weights;
+	for (int i = 0; i < static_cast<int>(size); i++) {
+		for (int j = 0; j < static_cast<int>(size); j++) {
+			weights.contrast.push_back(static_cast<double>((i - j) * (i - j)));
+			weights.homogeneity.push_back(1.0 / static_cast<double>(1 + (i - j) * (i - j)));
+		}
+	}
+
+	return weights;
+}
+
+/*
+Precompute count * log(count) for every count up to the biggest possible one. Entropy of normalized GLCM is then
+log(N) - sum(c * log(c)) / N, with no logarithm per cell.
+@param maxCount - the biggest count in GLCM cell, which is amount of pairs in the window. Limited to MAX_ENTROPY_TABLE_COUNT.
+*/
+std::vector<double> makeCountLogCountTable(unsigned long long maxCount) {
+	maxCount = std::min<unsigned long long>(maxCount, MAX_ENTROPY_TABLE_COUNT);
+	std::vector<double> table(maxCount + 1, 0.0);
+	for (unsigned long long count = 1; count <= maxCount; count++) {
+		table[count] = static_cast<double>(count) * std::log(static_cast<double>(count));
+	}
+
+	return table;
+}
+
+/*
+Sum of count * log(count) over non-zero counts. Values are taken from the table, counts outside of it are calculated.
+*/
+double sumCountLogCount(const unsigned long long* counts, unsigned int cellsAmount, const std::vector<double>& countLogCountTable) {
+	const double* table = countLogCountTable.data();
+	unsigned long long tableSize = countLogCountTable.size();
+	double sum = 0.0;
+	for (unsigned int k = 0; k < cellsAmount; k++) {
+		unsigned long long count = counts[k];
+		if (count == 0) {
+			continue;
+		}
+
+		if (count < tableSize) {
+			sum += table[count];
+		}
+		else {
+			double value = static_cast<double>(count);
+			sum += value * std::log(value);
+		}
+	}
+
+	return sum;
+}
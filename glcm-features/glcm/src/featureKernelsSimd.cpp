@@ -0,0 +1,144 @@
+#include "../headers/featureKernels.h"
+
+#ifdef GLCM_X86_KERNELS
+
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// MSVC allows AVX2 intrinsics without special flags, GCC and Clang need target attribute on functions using them
+#if defined(__GNUC__) || defined(__clang__)
+#define TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#else
+#define TARGET_AVX2
+#define TARGET_SSE2
+#endif
+
+/*
+Check which SIMD instruction set is supported by CPU running the program.
+*/
+SimdLevel detectSimdLevel() {
+#if defined(__GNUC__) || defined(__clang__)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+		return SIMD_AVX2;
+	}
+	if (__builtin_cpu_supports("sse2")) {
+		return SIMD_SSE2;
+	}
+#elif defined(_MSC_VER)
+	int cpuInfo[4];
+	__cpuid(cpuInfo, 0);
+	int maxLeaf = cpuInfo[0];
+	__cpuid(cpuInfo, 1);
+	bool sse2 = (cpuInfo[3] & (1 << 26)) != 0;
+	bool fma = (cpuInfo[2] & (1 << 12)) != 0;
+	bool osxsave = (cpuInfo[2] & (1 << 27)) != 0;
+	bool avx = (cpuInfo[2] & (1 << 28)) != 0;
+	if (maxLeaf >= 7 && fma && osxsave && avx && (_xgetbv(0) & 6) == 6) {
+		__cpuidex(cpuInfo, 7, 0);
+		if ((cpuInfo[1] & (1 << 5)) != 0) {
+			return SIMD_AVX2;
+		}
+	}
+	if (sse2) {
+		return SIMD_SSE2;
+	}
+#endif
+	return SIMD_NONE;
+}
+
+/*
+Evaluate features with AVX2. Four counts are processed at once, counts below 2^52 are converted to double
+by putting them into mantissa of 2^52 and subtracting 2^52.
+*/
+TARGET_AVX2 FeatureValues calcFeatureValuesAvx2(GLCMView glcm, const FeatureWeights& weights, bool entropyNeeded) {
+	unsigned int cellsAmount = glcm.size * glcm.size;
+	const double* contrastWeights = weights.contrast.data();
+	const double* homogeneityWeights = weights.homogeneity.data();
+	const __m256d magic = _mm256_set1_pd(static_cast<double>(SIMD_MAX_PAIRS_AMOUNT));
+	const __m256i magicBits = _mm256_castpd_si256(magic);
+
+	__m256d energySum = _mm256_setzero_pd();
+	__m256d contrastSum = _mm256_setzero_pd();
+	__m256d homogeneitySum = _mm256_setzero_pd();
+	unsigned int k = 0;
+	for (; k + 4 <= cellsAmount; k += 4) {
+		__m256i counts = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(glcm.counts + k));
+		__m256d values = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(counts, magicBits)), magic);
+		energySum = _mm256_fmadd_pd(values, values, energySum);
+		contrastSum = _mm256_fmadd_pd(values, _mm256_loadu_pd(contrastWeights + k), contrastSum);
+		homogeneitySum = _mm256_fmadd_pd(values, _mm256_loadu_pd(homogeneityWeights + k), homogeneitySum);
+	}
+
+	alignas(32) double lanes[4];
+	double sums[3];
+	__m256d vectorSums[3] = { energySum, contrastSum, homogeneitySum };
+	for (int s = 0; s < 3; s++) {
+		_mm256_store_pd(lanes, vectorSums[s]);
+		sums[s] = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+	}
+
+	for (; k < cellsAmount; k++) {
+		double value = static_cast<double>(glcm.counts[k]);
+		sums[0] += value * value;
+		sums[1] += value * contrastWeights[k];
+		sums[2] += value * homogeneityWeights[k];
+	}
+
+	double entropy = entropyNeeded ? sumCountLogCount(glcm.counts, cellsAmount, weights.countLogCount) : 0.0;
+
+	return normalizeFeatureSums(sums[0], entropy, sums[1], sums[2], glcm.pairsAmount);
+}
+
+/*
+Evaluate features with SSE2. Two counts are processed at once, conversion to double as in AVX2 kernel.
+*/
+TARGET_SSE2 FeatureValues calcFeatureValuesSse2(GLCMView glcm, const FeatureWeights& weights, bool entropyNeeded) {
+	unsigned int cellsAmount = glcm.size * glcm.size;
+	const double* contrastWeights = weights.contrast.data();
+	const double* homogeneityWeights = weights.homogeneity.data();
+	const __m128d magic = _mm_set1_pd(static_cast<double>(SIMD_MAX_PAIRS_AMOUNT));
+	const __m128i magicBits = _mm_castpd_si128(magic);
+
+	__m128d energySum = _mm_setzero_pd();
+	__m128d contrastSum = _mm_setzero_pd();
+	__m128d homogeneitySum = _mm_setzero_pd();
+	unsigned int k = 0;
+	for (; k + 2 <= cellsAmount; k += 2) {
+		__m128i counts = _mm_loadu_si128(reinterpret_cast<const __m128i*>(glcm.counts + k));
+		__m128d values = _mm_sub_pd(_mm_castsi128_pd(_mm_or_si128(counts, magicBits)), magic);
+		energySum = _mm_add_pd(energySum, _mm_mul_pd(values, values));
+		contrastSum = _mm_add_pd(contrastSum, _mm_mul_pd(values, _mm_loadu_pd(contrastWeights + k)));
+		homogeneitySum = _mm_add_pd(homogeneitySum, _mm_mul_pd(values, _mm_loadu_pd(homogeneityWeights + k)));
+	}
+
+	alignas(16) double lanes[2];
+	double sums[3];
+	__m128d vectorSums[3] = { energySum, contrastSum, homogeneitySum };
+	for (int s = 0; s < 3; s++) {
+		_mm_store_pd(lanes, vectorSums[s]);
+		sums[s] = lanes[0] + lanes[1];
+	}
+
+	for (; k < cellsAmount; k++) {
+		double value = static_cast<double>(glcm.counts[k]);
+		sums[0] += value * value;
+		sums[1] += value * contrastWeights[k];
+		sums[2] += value * homogeneityWeights[k];
+	}
+
+	double entropy = entropyNeeded ? sumCountLogCount(glcm.counts, cellsAmount, weights.countLogCount) : 0.0;
+
+	return normalizeFeatureSums(sums[0], entropy, sums[1], sums[2], glcm.pairsAmount);
+}
+
+#else
+
+SimdLevel detectSimdLevel() {
+	return SIMD_NONE;
+}
+
+#endif
@@ -0,0 +1,105 @@
+#include "../headers/featureStack.h"
+
+/**
+Create empty stack of feature bands.
+@param name - name of saved file without extension. File is saved in directory of feature images.
+@param bandsAmount - amount of bands, every one has to be set before saving.
+@param compression - compression of STACKED_TIFF pages. STACKED_NPY is always uncompressed.
+*/
+FeatureStack::FeatureStack(std::string name, size_t bandsAmount, StackCompression compression) {
+	this->_name = name;
+	this->_compression = compression;
+	this->_bandNames = std::vector<std::string>(bandsAmount);
+	this->_bands = std::vector<cv::Mat>(bandsAmount);
+}
+
+/**
+Put calculated feature image into the stack. Pixels are shared, not copied.
+@param bandIndex - position of band in saved file.
+@param featureImage - CV_32FC1 feature image created by GLCM_features::featureMaps().
+*/
+void FeatureStack::setBand(size_t bandIndex, std::unique_ptr<Image>& featureImage) {
+	std::lock_guard<std::mutex> lock(this->_mutex);
+	if (this->_directoryPath.empty()) {
+		this->_directoryPath = std::filesystem::path(featureImage->getPath()).parent_path().string();
+	}
+	this->_bandNames[bandIndex] = featureImage->getImageInfo().imageName;
+	this->_bands[bandIndex] = featureImage->getImage();
+}
+
+/**
+Save all bands into one file and their names into band index.
+@param outputFormat - STACKED_TIFF or STACKED_NPY.
+@return true if both files were saved.
+*/
+bool FeatureStack::save(FeatureImageFormat outputFormat) {
+	std::lock_guard<std::mutex> lock(this->_mutex);
+	std::string extension = outputFormat == STACKED_NPY ? ".npy" : ".tiff";
+	std::string path = (std::filesystem::path(this->_directoryPath) / this->_name).string();
+
+	bool check = false;
+	for (auto& band : this->_bands) {
+		if (band.empty() || band.type() != CV_32FC1 || band.rows != this->_bands.front().rows || band.cols != this->_bands.front().cols) {
+			std::cerr << "Saving " + this->_name + extension + " FAILED! Bands are missing or differ in size." << std::endl;
+			return false;
+		}
+	}
+	if (!this->_bands.empty()) {
+		check = outputFormat == STACKED_NPY ? this->saveNpy(path + extension) : this->saveTiff(path + extension);
+		check = check && this->saveBandIndex(path + "_bands.txt");
+	}
+
+	if (check) {
+		std::cout << "Successfully saved " + this->_name + extension + " with " + std::to_string(this->_bands.size()) + " bands" << std::endl;
+	}
+	else {
+		std::cerr << "Saving " + this->_name + extension + " FAILED!" << std::endl;
+	}
+
+	return check;
+}
+
+bool FeatureStack::saveTiff(std::string path) {
+	GLCM_TIME_STAGE(STAGE_SAVE_IMAGE);
+	// TIFF compression tags: 1 - none, 5 - LZW, 8 - deflate
+	int compressionTag = 1;
+	if (this->_compression == STACK_LZW) {
+		compressionTag = 5;
+	}
+	else if (this->_compression == STACK_DEFLATE) {
+		compressionTag = 8;
+	}
+
+	bool saved = cv::imwritemulti(path, this->_bands, { cv::IMWRITE_TIFF_COMPRESSION, compressionTag });
+	if (saved) {
+		GLCM_COUNT_FILE_BYTES(path);
+	}
+
+	return saved;
+}
+
+/*
+Bands are streamed one after another into (bands, rows, cols) array, no copy of the whole stack is made.
+*/
+bool FeatureStack::saveNpy(std::string path) {
+	int rows = this->_bands.front().rows;
+	StripWriter writer(path, rows, this->_bands.front().cols, CV_32FC1, static_cast<int>(this->_bands.size()));
+	for (auto& band : this->_bands) {
+		writer.writeRows(band, 0, rows);
+	}
+
+	return writer.isGood() && writer.isComplete();
+}
+
+bool FeatureStack::saveBandIndex(std::string path) {
+	std::ofstream indexFile(path);
+	for (size_t n = 0; n < this->_bandNames.size(); n++) {
+		indexFile << n << " " << this->_bandNames[n] << "\n";
+	}
+	indexFile.close();
+	if (indexFile) {
+		GLCM_COUNT_FILE_BYTES(path);
+	}
+
+	return static_cast<bool>(indexFile);
+}
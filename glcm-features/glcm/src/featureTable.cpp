@@ -0,0 +1,104 @@
+#include "../headers/featureTable.h"
+
+/**
+Create table of given pixels with all values NaN.
+@param points - pixels of table rows, x is column and y is row of the image.
+@param columnNames - names of feature columns.
+*/
+FeatureTable::FeatureTable(std::vector<cv::Point> points, std::vector<std::string> columnNames) {
+	this->_points = points;
+	this->_columnNames = columnNames;
+	this->_values = cv::Mat(static_cast<int>(this->_points.size()), static_cast<int>(this->_columnNames.size()), CV_32FC1, cv::Scalar(std::numeric_limits<float>::quiet_NaN()));
+}
+
+void FeatureTable::setValue(int row, int column, double value) {
+	this->_values.at<float>(row, column) = static_cast<float>(value);
+}
+
+/**
+Save table as CSV with header. First two columns are row and col of the pixel, missing values are written as nan.
+@param path - path of created file.
+@return true if file was written.
+*/
+bool FeatureTable::saveCsv(std::string path) {
+	GLCM_TIME_STAGE(STAGE_SAVE_IMAGE);
+	std::ofstream file(path);
+	file << "row,col";
+	for (auto& columnName : this->_columnNames) {
+		file << "," << columnName;
+	}
+	file << "\n";
+
+	// 9 significant digits are enough to read the same float back
+	file << std::setprecision(9);
+	for (int i = 0; i < this->_values.rows; i++) {
+		file << this->_points[i].y << "," << this->_points[i].x;
+		const float* valuesRow = this->_values.ptr<float>(i);
+		for (int j = 0; j < this->_values.cols; j++) {
+			file << ",";
+			if (std::isnan(valuesRow[j])) {
+				file << "nan";
+			}
+			else {
+				file << valuesRow[j];
+			}
+		}
+		file << "\n";
+	}
+	file.close();
+	if (file) {
+		GLCM_COUNT_FILE_BYTES(path);
+	}
+
+	return static_cast<bool>(file);
+}
+
+/**
+Save table as (pixels, 2 + columns) float32 NumPy array. First two columns are row and col of the pixel, exact for
+images up to 2^24 pixels wide. Column names are saved next to it in "<name>_columns.txt", one per line.
+@param path - path of created .npy file.
+@return true if both files were written.
+*/
+bool FeatureTable::saveNpy(std::string path) {
+	GLCM_TIME_STAGE(STAGE_SAVE_IMAGE);
+	cv::Mat table(this->_values.rows, this->_values.cols + 2, CV_32FC1);
+	for (int i = 0; i < this->_values.rows; i++) {
+		float* tableRow = table.ptr<float>(i);
+		const float* valuesRow = this->_values.ptr<float>(i);
+		tableRow[0] = static_cast<float>(this->_points[i].y);
+		tableRow[1] = static_cast<float>(this->_points[i].x);
+		std::copy(valuesRow, valuesRow + this->_values.cols, tableRow + 2);
+	}
+
+	StripWriter writer(path, table.rows, table.cols, CV_32FC1);
+	writer.writeRows(table, 0, table.rows);
+
+	std::string columnsPath = std::filesystem::path(path).replace_extension("").string() + "_columns.txt";
+	std::ofstream columnsFile(columnsPath);
+	columnsFile << "row\ncol\n";
+	for (auto& columnName : this->_columnNames) {
+		columnsFile << columnName << "\n";
+	}
+	columnsFile.close();
+	if (columnsFile) {
+		GLCM_COUNT_FILE_BYTES(columnsPath);
+	}
+
+	return writer.isGood() && writer.isComplete() && static_cast<bool>(columnsFile);
+}
+
+std::vector<cv::Point> FeatureTable::getPoints() {
+	return this->_points;
+}
+
+std::vector<std::string> FeatureTable::getColumnNames() {
+	return this->_columnNames;
+}
+
+/**
+Get values of features, row i belongs to point i and column j to column name j.
+@return CV_32FC1 matrix of points x columns.
+*/
+cv::Mat FeatureTable::getValues() {
+	return this->_values;
+}
@@ -1,141 +1,356 @@
 ﻿#include "../headers/glcm.h"
 
-GLCM::GLCM(std::shared_ptr<Image> image) {
+/**
+Create GLCM of the image.
+@param image - successfully loaded image from disk.
+@param storage - FULL_MATRIX keeps whole L x L GLCM, SUM_DIFF_HISTOGRAMS keeps only sum and difference
+		histograms of pairs (2L - 1 bins each), which is enough for features calculated with sum and difference histograms.
+		SPARSE_MATRIX keeps whole matrix too, but also ascending list of occupied cells, so clearing GLCM and evaluating
+		features touch only non-zero cells. Suitable when window has much less pairs than GLCM cells.
+*/
+GLCM::GLCM(std::shared_ptr<Image> image, GLCMStorage storage) {
 	this->_image = image;
 	this->_greyLevels = this->_image->getImageInfo().grayLevels;
+	this->_levelIndices = this->_image->getLevelIndexImage();
 	this->_size = this->_image->getImageInfo().grayLevelsAmount;
+	this->_storage = storage;
 
-	this->_glcm = std::make_shared<std::shared_ptr<double[]>[]>(this->_size);
-	for (int i = 0; i < this->_size; ++i) {
-		this->_glcm[i] = std::make_shared<double[]>(this->_size);
+	if (this->_storage == SUM_DIFF_HISTOGRAMS) {
+		this->_glcm = std::vector<unsigned long long>(2 * (2 * this->_size - 1));
+	}
+	else {
+		this->_glcm = std::vector<unsigned long long>(this->_size * this->_size);
 	}
 
+	this->createPairCodeTables();
 	this->clearGLCM();
 }
 
+/*
+Create tables translating pair code i * L + j into code of reversed pair and into bins of sum and difference histograms,
+so pairs read from pair code images need no division.
+*/
+void GLCM::createPairCodeTables() {
+	unsigned int codesAmount = this->_size * this->_size;
+	unsigned int binsAmount = 2 * this->_size - 1;
+	this->_transposedCodes = std::vector<ushort>(codesAmount);
+	this->_sumBins = std::vector<ushort>(codesAmount);
+	this->_differenceBins = std::vector<ushort>(codesAmount);
+	for (unsigned int i = 0; i < this->_size; i++) {
+		for (unsigned int j = 0; j < this->_size; j++) {
+			unsigned int code = i * this->_size + j;
+			this->_transposedCodes[code] = static_cast<ushort>(j * this->_size + i);
+			this->_sumBins[code] = static_cast<ushort>(i + j);
+			this->_differenceBins[code] = static_cast<ushort>(binsAmount + i + (this->_size - 1) - j);
+		}
+	}
+}
+
+/*
+Get pair code images of given offsets from the image. Kept until GLCM is calculated with other offsets.
+*/
+void GLCM::loadPairCodes(const std::vector<std::pair<int, int>>& offsets) {
+	if (offsets == this->_pairCodesOffsets) {
+		return;
+	}
+
+	this->_pairCodesOffsets = offsets;
+	this->_pairCodes.clear();
+	for (auto offset : offsets) {
+		this->_pairCodes.push_back(this->_image->getPairCodeImage(offset));
+	}
+}
+
 void GLCM::clearGLCM() {
-	for (int i = 0; i < this->_size; i++) {
-		for (int j = 0; j < this->_size; j++) {
-			this->_glcm[i][j] = 0.0;
+	if (this->_storage == SPARSE_MATRIX) {
+		for (auto code : this->_occupiedCodes) {
+			this->_glcm[code] = 0;
 		}
+		this->_occupiedCodes.clear();
+	}
+	else {
+		std::fill(this->_glcm.begin(), this->_glcm.end(), 0);
+	}
+	this->_pairsAmount = 0;
+}
+
+/*
+Add weight to cell of sparse GLCM and keep list of occupied cells sorted. Weight can be negative in two's complement,
+cell which drops to zero is removed from the list. List holds at most pairs of one window, so shifting it is cheap.
+*/
+inline void GLCM::addSparseCount(unsigned int code, unsigned long long weight) {
+	unsigned long long& count = this->_glcm[code];
+	bool wasEmpty = count == 0;
+	count += weight;
+	if (wasEmpty) {
+		this->_occupiedCodes.insert(std::lower_bound(this->_occupiedCodes.begin(), this->_occupiedCodes.end(), code), static_cast<ushort>(code));
+	}
+	else if (count == 0) {
+		this->_occupiedCodes.erase(std::lower_bound(this->_occupiedCodes.begin(), this->_occupiedCodes.end(), code));
 	}
 }
 
 /**
 Calculate GLCM with given offset of whole image
-@param offset - pair representing offsets. Allowed values are: (1, 0), (0, 1), (1, 1) or (-1, 1).
+@param offset - pair representing offsets. Any non-zero (dx, dy).
 @param horizontal - horizontal GLCM means transformation of calculated GLCM into symmetric matrix. For example
 		when there is a match with offset is (1, 0), horizontal GLCM also count match with (-1, 0) offset.
 */
 void GLCM::calculateGLCM(std::pair<int, int> offset, bool horizontal) {
+	GLCM_TIME_STAGE(STAGE_GLCM_ACCUMULATION);
 	if (!this->checkOffset(offset)) {
 		throw new BadOffset();
 	}
 
 	this->clearGLCM();
+	this->loadPairCodes({ offset });
 
-	cv::Mat matrix = this->_image->getImage();
 	unsigned int width = this->_image->getImageInfo().width;
 	unsigned int height = this->_image->getImageInfo().height;
-	for (int i = 0; i < height; i++) {
-		if (i + offset.second < 0 || i + offset.second >= height) {
-			continue;
-		}
+	auto [firstRow, lastRow, firstCol, lastCol] = this->getPairsRange(offset, 0, 0, height, width);
+	this->addPairs(0, firstRow, lastRow, firstCol, lastCol, horizontal, 1);
+}
 
-		for (int j = 0; j < width; j++) {
-			if (j + offset.first < 0 || j + offset.first >= width) {
-				continue;
-			}
+/*
+Check if offset is legal. Any (dx, dy) distance and direction is allowed, except (0, 0) pairing pixel with itself.
+@param offset - pair representing offsets.
+@return true if offset is valid, false when offset is illegal.
+*/
+bool GLCM::checkOffset(std::pair<int, int> offset) {
+	return offset.first != 0 || offset.second != 0;
+}
 
-			int currentPixelIndex = this->findGreyLevelValueInVector(matrix.at<uchar>(i, j));
-			int neighbourPixelIndex = this->findGreyLevelValueInVector(matrix.at<uchar>(i + offset.second, j + offset.first));
-			this->_glcm[currentPixelIndex][neighbourPixelIndex] += 1.0;
-		}
-	}
+/*
+Get range of pixels in given rectangle, which have their neighbour inside the rectangle.
+@return first row, last row (exclusive), first column, last column (exclusive).
+*/
+std::tuple<int, int, int, int> GLCM::getPairsRange(std::pair<int, int> offset, int top, int left, int height, int width) {
+	int firstRow = top + std::max(0, -offset.second);
+	int lastRow = top + height - std::max(0, offset.second);
+	int firstCol = left + std::max(0, -offset.first);
+	int lastCol = left + width - std::max(0, offset.first);
 
+	return std::make_tuple(firstRow, lastRow, firstCol, lastCol);
+}
+
+unsigned long long GLCM::countPairsInRange(std::tuple<int, int, int, int> pairsRange, bool horizontal) {
+	auto [firstRow, lastRow, firstCol, lastCol] = pairsRange;
+	unsigned long long pairsAmount = static_cast<unsigned long long>(std::max(0, lastRow - firstRow)) * std::max(0, lastCol - firstCol);
 	if (horizontal) {
-		this->makeGLCMHorizontal();
+		pairsAmount *= 2;
 	}
-	this->normalizeGLCM();
+
+	return pairsAmount;
 }
 
 /*
-Check if offset is legal. Allowed values are: (1, 0), (0, 1), (1, 1) or (-1, 1).
-@param offset - pair representing offsets.
-@return true if offset is valid, false when offset is illegal.
+Add pairs of pixels from given range and their neighbours to GLCM. Negative weight removes pairs.
+@param offsetIndex - index of offset in offsets of loaded pair codes.
 */
-bool GLCM::checkOffset(std::pair<int, int> offset) {
-	if (
-		(offset.first == 1 && offset.second == 0) ||
-		(offset.first == 0 && offset.second == 1) ||
-		(offset.first == 1 && offset.second == 1) ||
-		(offset.first == -1 && offset.second == 1)
-		) {
-		return true;
+void GLCM::addPairs(int offsetIndex, int firstRow, int lastRow, int firstCol, int lastCol, bool horizontal, long long weight) {
+	if (firstRow >= lastRow || firstCol >= lastCol) {
+		return;
+	}
+
+	const cv::Mat& pairCodes = this->_pairCodes[offsetIndex];
+	if (!pairCodes.empty()) {
+		for (int i = firstRow; i < lastRow; i++) {
+			this->addRowPairCodes(pairCodes.ptr<ushort>(i), firstCol, lastCol, horizontal, weight);
+		}
 	}
 	else {
-		return false;
+		std::pair<int, int> offset = this->_pairCodesOffsets[offsetIndex];
+		for (int i = firstRow; i < lastRow; i++) {
+			const uchar* currentRow = this->_levelIndices.ptr<uchar>(i);
+			const uchar* neighbourRow = this->_levelIndices.ptr<uchar>(i + offset.second) + offset.first;
+			this->addRowPairs(currentRow, neighbourRow, firstCol, lastCol, horizontal, weight);
+		}
 	}
+	GLCM_COUNT(COUNTER_PAIRS, static_cast<unsigned long long>(lastRow - firstRow) * (lastCol - firstCol));
+
+	this->_pairsAmount += weight * this->countPairsInRange(std::make_tuple(firstRow, lastRow, firstCol, lastCol), horizontal);
 }
 
-unsigned int GLCM::findGreyLevelValueInVector(unsigned int value) {
-	unsigned int index;
-	for (index = 0; index < this->_greyLevels.size(); index++) {
-		if (value == this->_greyLevels[index]) {
-			return index;
+unsigned long long GLCM::calcOffsetWeights(const std::vector<std::pair<int, int>>& offsets, int height, int width, bool horizontal) {
+	return GLCM::calcOffsetWeights(offsets, height, width, horizontal, this->_offsetWeights);
+}
+
+/*
+Calculate integer weights of offsets, so every offset has the same share in GLCM regardless of its amount of pairs.
+Weighted counts divided by weighted pairs amount give exactly mean of normalized GLCMs of every offset.
+When least common multiple of pairs amounts does not fit, as for many offsets of different lengths in big windows,
+every offset gets weighted pairs amount close to the same share of SIMD_MAX_PAIRS_AMOUNT instead. Shares of offsets
+then differ by relative error below offsets amount * pairs amount / 2^51, far below float precision of features.
+Weights are stored in reused buffer, so no memory is allocated for repeated calls with the same amount of offsets.
+@param offsets - vector of pairs representing offsets.
+@param height, width - sizes of rectangle with pairs.
+@param horizontal - whether pairs are counted in both directions.
+@param offsetWeights - buffer for weights, in order of offsets.
+@return Sum of weighted pairs of all offsets.
+*/
+unsigned long long GLCM::calcOffsetWeights(const std::vector<std::pair<int, int>>& offsets, int height, int width, bool horizontal, std::vector<unsigned long long>& offsetWeights) {
+	offsetWeights.resize(offsets.size());
+
+	unsigned long long commonMultiple = 1;
+	bool commonMultipleFits = true;
+	for (auto offset : offsets) {
+		unsigned long long pairsAmount = GLCM::countPairsInRange(GLCM::getPairsRange(offset, 0, 0, height, width), horizontal);
+		if (pairsAmount == 0) {
+			continue;
+		}
+
+		unsigned long long factor = pairsAmount / std::gcd(commonMultiple, pairsAmount);
+		if (commonMultiple > ULLONG_MAX / factor / offsets.size()) {
+			commonMultipleFits = false;
+			break;
 		}
+		commonMultiple *= factor;
 	}
 
-	throw new BadPixelValue();
+	// half of the bound leaves room for rounding up weights of all offsets
+	unsigned long long offsetShare = SIMD_MAX_PAIRS_AMOUNT / 2 / offsets.size();
+	unsigned long long weightedPairsAmount = 0;
+	for (int k = 0; k < offsets.size(); k++) {
+		unsigned long long pairsAmount = GLCM::countPairsInRange(GLCM::getPairsRange(offsets[k], 0, 0, height, width), horizontal);
+		if (pairsAmount == 0) {
+			offsetWeights[k] = 0;
+		}
+		else if (commonMultipleFits) {
+			offsetWeights[k] = commonMultiple / pairsAmount;
+		}
+		else {
+			offsetWeights[k] = std::max(1ULL, (offsetShare + pairsAmount / 2) / pairsAmount);
+		}
+		weightedPairsAmount += offsetWeights[k] * pairsAmount;
+	}
+
+	return weightedPairsAmount;
 }
 
-void GLCM::makeGLCMHorizontal() {
-	std::unique_ptr<std::unique_ptr<double[]>[]> transponedGLCM = std::move(this->createTransponedGLCM());
+/*
+Add weighted pairs of all offsets from given rectangle in one scan of its rows. Weights have to be calculated before.
+*/
+void GLCM::addMeanPairs(const std::vector<std::pair<int, int>>& offsets, int top, int left, int height, int width, bool horizontal) {
+	for (int i = top; i < top + height; i++) {
+		const uchar* currentRow = this->_levelIndices.ptr<uchar>(i);
+		for (int k = 0; k < offsets.size(); k++) {
+			std::pair<int, int> offset = offsets[k];
+			// do not go outside rectangle
+			if (i + offset.second < top || i + offset.second >= top + height) {
+				continue;
+			}
 
-	for (int i = 0; i < this->_size; i++) {
-		for (int j = 0; j < this->_size; j++) {
-			this->_glcm[i][j] += transponedGLCM[i][j];
+			unsigned long long weight = this->_offsetWeights[k];
+			int firstCol = left + std::max(0, -offset.first);
+			int lastCol = left + width - std::max(0, offset.first);
+			if (!this->_pairCodes[k].empty()) {
+				this->addRowPairCodes(this->_pairCodes[k].ptr<ushort>(i), firstCol, lastCol, horizontal, weight);
+			}
+			else {
+				const uchar* neighbourRow = this->_levelIndices.ptr<uchar>(i + offset.second) + offset.first;
+				this->addRowPairs(currentRow, neighbourRow, firstCol, lastCol, horizontal, weight);
+			}
+			GLCM_COUNT(COUNTER_PAIRS, std::max(0, lastCol - firstCol));
 		}
 	}
 }
 
-std::unique_ptr<std::unique_ptr<double[]>[]> GLCM::createTransponedGLCM() {
-	std::unique_ptr<std::unique_ptr<double[]>[]> transponedGLCM = std::make_unique<std::unique_ptr<double[]>[]>(this->_size);
-	for (int i = 0; i < this->_size; ++i) {
-		transponedGLCM[i] = std::make_unique<double[]>(this->_size);
+/*
+Add pairs of pixels from one row and their neighbours. Neighbour row has to be already shifted by horizontal offset.
+Full matrix counts pair in (current, neighbour) cell, histograms count it in current + neighbour bin of sum histogram
+and current - neighbour bin of difference histogram.
+*/
+void GLCM::addRowPairs(const uchar* currentRow, const uchar* neighbourRow, int firstCol, int lastCol, bool horizontal, unsigned long long weight) {
+	if (this->_storage == SUM_DIFF_HISTOGRAMS) {
+		unsigned long long* sumHistogram = this->_glcm.data();
+		// centered, so it can be indexed with negative differences
+		unsigned long long* differenceHistogram = this->_glcm.data() + (2 * this->_size - 1) + (this->_size - 1);
+		for (int j = firstCol; j < lastCol; j++) {
+			int current = currentRow[j];
+			int neighbour = neighbourRow[j];
+			sumHistogram[current + neighbour] += weight;
+			differenceHistogram[current - neighbour] += weight;
+			if (horizontal) {
+				sumHistogram[current + neighbour] += weight;
+				differenceHistogram[neighbour - current] += weight;
+			}
+		}
+		return;
 	}
 
-	for (int i = 0; i < this->_size; i++) {
-		for (int j = 0; j < this->_size; j++) {
-			transponedGLCM[i][j] = this->_glcm[j][i];
+	if (this->_storage == SPARSE_MATRIX) {
+		for (int j = firstCol; j < lastCol; j++) {
+			this->addSparseCount(currentRow[j] * this->_size + neighbourRow[j], weight);
+			if (horizontal) {
+				this->addSparseCount(neighbourRow[j] * this->_size + currentRow[j], weight);
+			}
 		}
+		return;
 	}
 
-	return transponedGLCM;
+	unsigned long long* glcm = this->_glcm.data();
+	for (int j = firstCol; j < lastCol; j++) {
+		glcm[currentRow[j] * this->_size + neighbourRow[j]] += weight;
+		if (horizontal) {
+			glcm[neighbourRow[j] * this->_size + currentRow[j]] += weight;
+		}
+	}
 }
 
-void GLCM::normalizeGLCM() {
-	unsigned int sum = 0;
-	for (int i = 0; i < this->_size; i++) {
-		for (int j = 0; j < this->_size; j++) {
-			sum += static_cast<unsigned int>(this->_glcm[i][j]);
+/*
+Add pairs of one row of pair code image. Every pair is one read of its code, reversed pairs and histogram bins
+are looked up in tables.
+*/
+void GLCM::addRowPairCodes(const ushort* pairCodeRow, int firstCol, int lastCol, bool horizontal, unsigned long long weight) {
+	unsigned long long* glcm = this->_glcm.data();
+	if (this->_storage == SUM_DIFF_HISTOGRAMS) {
+		const ushort* sumBins = this->_sumBins.data();
+		const ushort* differenceBins = this->_differenceBins.data();
+		for (int j = firstCol; j < lastCol; j++) {
+			ushort code = pairCodeRow[j];
+			glcm[sumBins[code]] += weight;
+			glcm[differenceBins[code]] += weight;
+			if (horizontal) {
+				glcm[sumBins[code]] += weight;
+				glcm[differenceBins[this->_transposedCodes[code]]] += weight;
+			}
+		}
+		return;
+	}
+
+	if (this->_storage == SPARSE_MATRIX) {
+		for (int j = firstCol; j < lastCol; j++) {
+			this->addSparseCount(pairCodeRow[j], weight);
+			if (horizontal) {
+				this->addSparseCount(this->_transposedCodes[pairCodeRow[j]], weight);
+			}
 		}
+		return;
 	}
 
-	for (int i = 0; i < this->_size; i++) {
-		for (int j = 0; j < this->_size; j++) {
-			this->_glcm[i][j] /= (double)sum;
+	if (horizontal) {
+		const ushort* transposedCodes = this->_transposedCodes.data();
+		for (int j = firstCol; j < lastCol; j++) {
+			glcm[pairCodeRow[j]] += weight;
+			glcm[transposedCodes[pairCodeRow[j]]] += weight;
 		}
+		return;
+	}
+
+	for (int j = firstCol; j < lastCol; j++) {
+		glcm[pairCodeRow[j]] += weight;
 	}
 }
 
 /**
-Calculate GLCM with given vector of offsets in a square part of original image
-@param offsets - vector of pairs representing offsets. Allowed values are: (1, 0), (0, 1), (1, 1), (-1, 1).
+Calculate GLCM with given vector of offsets of whole image. All offsets are counted in one scan of the image
+into one GLCM, without intermediate GLCMs.
+@param offsets - vector of pairs representing offsets. Any non-zero (dx, dy).
 @param horizontal - horizontal GLCM means transformation of calculated GLCM into symmetric matrix. For example
 		when there is a match with offset is (1, 0), horizontal GLCM also count match with (-1, 0) offset.
 */
-void GLCM::calculateMeanGLCM(std::vector<std::pair<int, int>> offsets, bool horizontal) {
+void GLCM::calculateMeanGLCM(const std::vector<std::pair<int, int>>& offsets, bool horizontal) {
+	GLCM_TIME_STAGE(STAGE_GLCM_ACCUMULATION);
 	if (offsets.empty()) {
 		throw new NoOffsets();
 	}
@@ -146,33 +361,19 @@ void GLCM::calculateMeanGLCM(std::vector<std::pair<int, int>> offsets, bool hori
 		}
 	}
 
-	this->clearGLCM();
-	for (auto offset : offsets) {
-		std::unique_ptr<GLCM> glcm = std::make_unique<GLCM>(this->_image);
-		glcm->calculateGLCM(offset, horizontal);
+	int width = this->_levelIndices.cols;
+	int height = this->_levelIndices.rows;
+	unsigned long long pairsAmount = this->calcOffsetWeights(offsets, height, width, horizontal);
 
-		std::shared_ptr<std::shared_ptr<double[]>[]> matrix = glcm->getGLCM();
-		this->addIntermediateGLCM(matrix);
-	}
-
-	for (int i = 0; i < this->_size; i++) {
-		for (int j = 0; j < this->_size; j++) {
-			this->_glcm[i][j] /= static_cast<double>(offsets.size());
-		}
-	}
-}
-
-void GLCM::addIntermediateGLCM(std::shared_ptr<std::shared_ptr<double[]>[]> glcm) {
-	for (int i = 0; i < this->_size; i++) {
-		for (int j = 0; j < this->_size; j++) {
-			this->_glcm[i][j] += glcm[i][j];
-		}
-	}
+	this->clearGLCM();
+	this->loadPairCodes(offsets);
+	this->addMeanPairs(offsets, 0, 0, height, width, horizontal);
+	this->_pairsAmount = pairsAmount;
 }
 
 /**
 Calculate GLCM with given offset in a square part of original image
-@param offset - pair representing offsets. Allowed values are: (1, 0), (0, 1), (1, 1) or (-1, 1).
+@param offset - pair representing offsets. Any non-zero (dx, dy).
 @param top - row index of left top element of window
 @param left - column index of left top element of window
 @param windowSize - window size defining scope of image to calculate. Should be odd.
@@ -180,49 +381,61 @@ Calculate GLCM with given offset in a square part of original image
 		when there is a match with offset is (1, 0), horizontal GLCM also count match with (-1, 0) offset.
 */
 void GLCM::calculateGLCM(std::pair<int, int> offset, int startingRow, int startingCol, int windowSize, bool horizontal) {
+	GLCM_TIME_STAGE(STAGE_GLCM_ACCUMULATION);
 	if (!this->checkOffset(offset)) {
 		throw new BadOffset();
 	}
 
 	this->clearGLCM();
+	this->loadPairCodes({ offset });
 
-	cv::Mat matrix = this->_image->getImage();
-	unsigned int width = this->_image->getImageInfo().width;
-	unsigned int height = this->_image->getImageInfo().height;
-	for (int i = startingRow; i < startingRow + windowSize; i++) {
-		// do not go outside matrix
-		if (i + offset.second < 0 || i + offset.second >= startingRow + windowSize) {
-			continue;
-		}
+	// only pairs with both pixels inside window
+	auto [firstRow, lastRow, firstCol, lastCol] = this->getPairsRange(offset, startingRow, startingCol, windowSize, windowSize);
+	this->addPairs(0, firstRow, lastRow, firstCol, lastCol, horizontal, 1);
+}
 
-		for (int j = startingCol; j < startingCol + windowSize; j++) {
-			// do not go outside matrix
-			if (j + offset.first < 0 || j + offset.first >= startingCol + windowSize) {
-				continue;
-			}
+/**
+Calculate GLCM with given vector of offsets in a square part of original image. All offsets are counted in one scan
+of the window into one GLCM, without intermediate GLCMs or memory allocation.
+@param offsets - vector of pairs representing offsets. Any non-zero (dx, dy).
+@param top - row index of left top element of window
+@param left - column index of left top element of window
+@param windowSize - window size defining scope of image to calculate. Should be odd.
+@param horizontal - horizontal GLCM means transformation of calculated GLCM into symmetric matrix. For example
+		when there is a match with offset is (1, 0), horizontal GLCM also count match with (-1, 0) offset.
+*/
+void GLCM::calculateMeanGLCM(const std::vector<std::pair<int, int>>& offsets, int top, int left, int windowSize, bool horizontal) {
+	GLCM_TIME_STAGE(STAGE_GLCM_ACCUMULATION);
+	if (offsets.empty()) {
+		throw new NoOffsets();
+	}
 
-			int currentPixelIndex = this->findGreyLevelValueInVector(matrix.at<uchar>(i, j));
-			int neighbourPixelIndex = this->findGreyLevelValueInVector(matrix.at<uchar>(i + offset.second, j + offset.first));
-			this->_glcm[currentPixelIndex][neighbourPixelIndex] += 1.0;
+	for (auto offset : offsets) {
+		if (!this->checkOffset(offset)) {
+			throw new BadOffset();
 		}
 	}
 
-	if (horizontal) {
-		this->makeGLCMHorizontal();
-	}
-	this->normalizeGLCM();
+	unsigned long long pairsAmount = this->calcOffsetWeights(offsets, windowSize, windowSize, horizontal);
+
+	this->clearGLCM();
+	this->loadPairCodes(offsets);
+	this->addMeanPairs(offsets, top, left, windowSize, windowSize, horizontal);
+	this->_pairsAmount = pairsAmount;
 }
 
 /**
-Calculate GLCM with given vector of offsets in a square part of original image
-@param offsets - vector of pairs representing offsets. Allowed values are: (1, 0), (0, 1), (1, 1), (-1, 1).
+Start sliding window GLCM calculation. Co-occurrence counts are kept between window moves, so each slide only adds
+pairs entering the window and removes pairs leaving it. Resulting GLCM is the same as calculateMeanGLCM() for the current window.
+@param offsets - vector of pairs representing offsets. Any non-zero (dx, dy).
 @param top - row index of left top element of window
 @param left - column index of left top element of window
 @param windowSize - window size defining scope of image to calculate. Should be odd.
 @param horizontal - horizontal GLCM means transformation of calculated GLCM into symmetric matrix. For example
 		when there is a match with offset is (1, 0), horizontal GLCM also count match with (-1, 0) offset.
 */
-void GLCM::calculateMeanGLCM(std::vector<std::pair<int, int>> offsets, int top, int left, int windowSize, bool horizontal) {
+void GLCM::startSlidingGLCM(const std::vector<std::pair<int, int>>& offsets, int top, int left, int windowSize, bool horizontal) {
+	GLCM_TIME_STAGE(STAGE_GLCM_ACCUMULATION);
 	if (offsets.empty()) {
 		throw new NoOffsets();
 	}
@@ -233,24 +446,138 @@ void GLCM::calculateMeanGLCM(std::vector<std::pair<int, int>> offsets, int top,
 		}
 	}
 
+	this->fillSlidingGLCM(offsets, top, left, windowSize, horizontal);
+}
+
+/*
+Count all pairs of sliding window from scratch. Not timed, callers time it together with their own work.
+*/
+void GLCM::fillSlidingGLCM(const std::vector<std::pair<int, int>>& offsets, int top, int left, int windowSize, bool horizontal) {
+	this->_slidingOffsets = offsets;
+	this->_slidingTop = top;
+	this->_slidingLeft = left;
+	this->_slidingWindowSize = windowSize;
+	this->_slidingHorizontal = horizontal;
+
+	this->calcOffsetWeights(offsets, windowSize, windowSize, horizontal);
+	this->_slidingWeights = this->_offsetWeights;
+
 	this->clearGLCM();
-	for (auto offset : offsets) {
-		std::unique_ptr<GLCM> glcm = std::make_unique<GLCM>(this->_image);
-		glcm->calculateGLCM(offset, top, left, windowSize, horizontal);
+	this->loadPairCodes(offsets);
+	for (int k = 0; k < this->_slidingOffsets.size(); k++) {
+		auto [firstRow, lastRow, firstCol, lastCol] = this->getPairsRange(offsets[k], top, left, windowSize, windowSize);
+		this->addPairs(k, firstRow, lastRow, firstCol, lastCol, horizontal, this->_slidingWeights[k]);
+	}
+}
+
+/**
+Move sliding window one column to the right. Not timed, slides are cheap enough to be timed per row by the caller.
+*/
+void GLCM::slideGLCMRight() {
+	for (int k = 0; k < this->_slidingOffsets.size(); k++) {
+		std::pair<int, int> offset = this->_slidingOffsets[k];
+		long long weight = this->_slidingWeights[k];
+		auto [firstRow, lastRow, firstCol, lastCol] = this->getPairsRange(offset, this->_slidingTop, this->_slidingLeft, this->_slidingWindowSize, this->_slidingWindowSize);
+		if (firstRow >= lastRow || firstCol >= lastCol) {
+			continue;
+		}
 
-		std::shared_ptr<std::shared_ptr<double[]>[]> matrix = glcm->getGLCM();
-		this->addIntermediateGLCM(matrix);
+		this->addPairs(k, firstRow, lastRow, firstCol, firstCol + 1, this->_slidingHorizontal, -weight);
+		this->addPairs(k, firstRow, lastRow, lastCol, lastCol + 1, this->_slidingHorizontal, weight);
 	}
 
-	for (int i = 0; i < this->_size; i++) {
-		for (int j = 0; j < this->_size; j++) {
-			this->_glcm[i][j] /= static_cast<double>(offsets.size());
+	this->_slidingLeft++;
+}
+
+/**
+Move sliding window one column to the left. Not timed, see slideGLCMRight().
+*/
+void GLCM::slideGLCMLeft() {
+	for (int k = 0; k < this->_slidingOffsets.size(); k++) {
+		std::pair<int, int> offset = this->_slidingOffsets[k];
+		long long weight = this->_slidingWeights[k];
+		auto [firstRow, lastRow, firstCol, lastCol] = this->getPairsRange(offset, this->_slidingTop, this->_slidingLeft, this->_slidingWindowSize, this->_slidingWindowSize);
+		if (firstRow >= lastRow || firstCol >= lastCol) {
+			continue;
 		}
+
+		this->addPairs(k, firstRow, lastRow, lastCol - 1, lastCol, this->_slidingHorizontal, -weight);
+		this->addPairs(k, firstRow, lastRow, firstCol - 1, firstCol, this->_slidingHorizontal, weight);
 	}
+
+	this->_slidingLeft--;
 }
 
 /**
-Print GLCM on console
+Move sliding window one row down. Not timed, see slideGLCMRight().
+*/
+void GLCM::slideGLCMDown() {
+	for (int k = 0; k < this->_slidingOffsets.size(); k++) {
+		std::pair<int, int> offset = this->_slidingOffsets[k];
+		long long weight = this->_slidingWeights[k];
+		auto [firstRow, lastRow, firstCol, lastCol] = this->getPairsRange(offset, this->_slidingTop, this->_slidingLeft, this->_slidingWindowSize, this->_slidingWindowSize);
+		if (firstRow >= lastRow || firstCol >= lastCol) {
+			continue;
+		}
+
+		this->addPairs(k, firstRow, firstRow + 1, firstCol, lastCol, this->_slidingHorizontal, -weight);
+		this->addPairs(k, lastRow, lastRow + 1, firstCol, lastCol, this->_slidingHorizontal, weight);
+	}
+
+	this->_slidingTop++;
+}
+
+/**
+Grow sliding window to bigger one with the same center. When weights of offsets are the same for both window sizes
+(e.g. single offset), only pairs of the ring between windows are added. Otherwise GLCM of the new window is recalculated.
+@param windowSize - new window size. Should be odd and not smaller than current one.
+*/
+void GLCM::expandSlidingGLCM(int windowSize) {
+	GLCM_TIME_STAGE(STAGE_GLCM_ACCUMULATION);
+	int margin = (windowSize - this->_slidingWindowSize) / 2;
+	int top = this->_slidingTop - margin;
+	int left = this->_slidingLeft - margin;
+
+	this->calcOffsetWeights(this->_slidingOffsets, windowSize, windowSize, this->_slidingHorizontal);
+	if (this->_offsetWeights != this->_slidingWeights) {
+		this->fillSlidingGLCM(this->_slidingOffsets, top, left, windowSize, this->_slidingHorizontal);
+		return;
+	}
+
+	for (int k = 0; k < this->_slidingOffsets.size(); k++) {
+		std::pair<int, int> offset = this->_slidingOffsets[k];
+		long long weight = this->_slidingWeights[k];
+		auto [innerFirstRow, innerLastRow, innerFirstCol, innerLastCol] = this->getPairsRange(offset, this->_slidingTop, this->_slidingLeft, this->_slidingWindowSize, this->_slidingWindowSize);
+		auto [firstRow, lastRow, firstCol, lastCol] = this->getPairsRange(offset, top, left, windowSize, windowSize);
+		if (innerFirstRow >= innerLastRow || innerFirstCol >= innerLastCol) {
+			innerFirstRow = innerLastRow = firstRow;
+		}
+
+		// rows above and below inner window, then columns on both sides of it
+		this->addPairs(k, firstRow, innerFirstRow, firstCol, lastCol, this->_slidingHorizontal, weight);
+		this->addPairs(k, innerLastRow, lastRow, firstCol, lastCol, this->_slidingHorizontal, weight);
+		this->addPairs(k, innerFirstRow, innerLastRow, firstCol, innerFirstCol, this->_slidingHorizontal, weight);
+		this->addPairs(k, innerFirstRow, innerLastRow, innerLastCol, lastCol, this->_slidingHorizontal, weight);
+	}
+
+	this->_slidingTop = top;
+	this->_slidingLeft = left;
+	this->_slidingWindowSize = windowSize;
+}
+
+/**
+Calculate sum of counts of GLCM of a window with given offsets. No count in GLCM cell can be bigger than it.
+@param offsets - vector of pairs representing offsets. Any non-zero (dx, dy).
+@param windowSize - window size defining scope of image to calculate. Should be odd.
+@param horizontal - horizontal GLCM means transformation of calculated GLCM into symmetric matrix.
+@return Sum of weighted counts of GLCM calculated with calculateMeanGLCM() or sliding window.
+*/
+unsigned long long GLCM::calcWindowPairsAmount(const std::vector<std::pair<int, int>>& offsets, int windowSize, bool horizontal) {
+	return this->calcOffsetWeights(offsets, windowSize, windowSize, horizontal);
+}
+
+/**
+Print GLCM on console. With SUM_DIFF_HISTOGRAMS storage sum and difference histograms are printed.
 @param coutPrecision - precision for printing floating-point values of GLCM
 */
 void GLCM::printGLCM(unsigned int coutPrecision) {
@@ -259,17 +586,44 @@ void GLCM::printGLCM(unsigned int coutPrecision) {
 		coutPrecision = maxCoutPrecision;
 	}
 
-	for (int i = 0; i < this->_size; i++) {
-		for (int j = 0; j < this->_size; j++) {
-			std::cout << std::fixed << std::setprecision(coutPrecision) << this->_glcm[i][j] << " ";
+	unsigned int rows = this->_storage == SUM_DIFF_HISTOGRAMS ? 2 : this->_size;
+	unsigned int cols = this->_storage == SUM_DIFF_HISTOGRAMS ? 2 * this->_size - 1 : this->_size;
+	for (int i = 0; i < rows; i++) {
+		for (int j = 0; j < cols; j++) {
+			std::cout << std::fixed << std::setprecision(coutPrecision) << this->_glcm[i * cols + j] / (double)this->_pairsAmount << " ";
 		}
 		std::cout << std::endl;
 	}
 	std::cout << std::endl;
 }
 
-std::shared_ptr<std::shared_ptr<double[]>[]> GLCM::getGLCM() {
-	return this->_glcm;
+/**
+Get view of GLCM counts. View is valid until next calculation or destruction of GLCM. For FULL_MATRIX and SPARSE_MATRIX storage.
+@return Contiguous size x size matrix of counts and their sum.
+*/
+GLCMView GLCM::getGLCM() {
+	return GLCMView{ this->_glcm.data(), this->_size, this->_pairsAmount };
+}
+
+/**
+Get view of sum and difference histograms. View is valid until next calculation or destruction of GLCM. Only for SUM_DIFF_HISTOGRAMS storage.
+@return Histograms with 2 * size - 1 bins and sum of counts of each of them.
+*/
+SumDiffView GLCM::getSumDiffHistograms() {
+	unsigned int binsAmount = 2 * this->_size - 1;
+	return SumDiffView{ this->_glcm.data(), this->_glcm.data() + binsAmount, this->_size, this->_pairsAmount };
+}
+
+/**
+Get view of occupied cells of GLCM. View is valid until next calculation or destruction of GLCM. Only for SPARSE_MATRIX storage.
+@return Whole matrix of counts with ascending list of its non-zero cells.
+*/
+SparseGLCMView GLCM::getSparseGLCM() {
+	return SparseGLCMView{ this->_glcm.data(), this->_occupiedCodes.data(), static_cast<unsigned int>(this->_occupiedCodes.size()), this->_size, this->_pairsAmount };
+}
+
+GLCMStorage GLCM::getStorage() {
+	return this->_storage;
 }
 
 int GLCM::getSize() {
@@ -4,26 +4,129 @@
 Constructor of GLCM_features class.
 @params image - successfully loaded image from disk.
 @params - windowSize - defining size of swuare window used for GLCM calculations. Should be odd positive number. If not, default size will be used.
+@params - computationMode - BRUTE_FORCE recalculates whole GLCM for every window, SLIDING_WINDOW updates GLCM
+		incrementally while window moves over the image, INTEGRAL_HISTOGRAMS reads GLCM of every window from integral
+		co-occurrence histograms, COLUMN_HISTOGRAMS updates GLCM with co-occurrence histograms of columns, which costs
+		the same for every window size. All modes give identical results.
 */
-GLCM_features::GLCM_features(std::shared_ptr<Image> image, unsigned int windowSize) {
+GLCM_features::GLCM_features(std::shared_ptr<Image> image, unsigned int windowSize, ComputationMode computationMode)
+	: GLCM_features(image, std::vector<unsigned int>{ windowSize }, computationMode) {
+}
+
+/*
+Constructor of GLCM_features class calculating features of several window sizes at once. Windows of all sizes with
+the same center are calculated in one traversal of the image, images of every size are created.
+@params image - successfully loaded image from disk.
+@params - windowSizes - sizes of square windows. Should be odd positive numbers. Wrong sizes are replaced with default size.
+@params - computationMode - BRUTE_FORCE calculates the smallest window and grows it into bigger ones, SLIDING_WINDOW
+		moves windows of all sizes together, INTEGRAL_HISTOGRAMS reads windows of all sizes from the same integral
+		histograms, COLUMN_HISTOGRAMS moves windows of all sizes together with own column histograms. All modes give
+		identical results.
+*/
+GLCM_features::GLCM_features(std::shared_ptr<Image> image, std::vector<unsigned int> windowSizes, ComputationMode computationMode) {
 	this->_image = image;
-	this->validWindowSize(windowSize);
+	for (auto windowSize : windowSizes) {
+		this->_windowSizes.push_back(this->validWindowSize(windowSize));
+	}
+	if (this->_windowSizes.empty()) {
+		this->_windowSizes.push_back(DEFAULT_WINDOW_SIZE);
+	}
+	std::sort(this->_windowSizes.begin(), this->_windowSizes.end());
+	this->_windowSizes.erase(std::unique(this->_windowSizes.begin(), this->_windowSizes.end()), this->_windowSizes.end());
+	this->_windowSize = this->_windowSizes.front();
+
 	this->_greyLevels = this->_image->getImageInfo().grayLevels;
+	this->_computationMode = computationMode;
+	this->_threadsAmount = DEFAULT_THREADS_AMOUNT;
+	this->_storage = FULL_MATRIX;
+	this->_featureWeights = makeFeatureWeights(this->_image->getImageInfo().grayLevelsAmount);
+	this->_simdLevel = detectSimdLevel();
+	this->_outputFormat = FLOAT_TIFF;
+	this->_compression = STACK_UNCOMPRESSED;
+}
+
+void GLCM_features::setComputationMode(ComputationMode computationMode) {
+	this->_computationMode = computationMode;
+}
+
+/*
+Set amount of threads used for calculating feature images. Rows of windows are split into equal bands, one per thread.
+Results do not depend on threads amount.
+@param threadsAmount - amount of threads. 0 means amount of hardware threads.
+*/
+void GLCM_features::setThreadsAmount(unsigned int threadsAmount) {
+	if (threadsAmount == 0) {
+		threadsAmount = std::max(1u, std::thread::hardware_concurrency());
+	}
+	this->_threadsAmount = threadsAmount;
+}
+
+/*
+Select what is kept for every window. FULL_MATRIX keeps whole GLCM and all features are exact, windows with much less
+pairs than GLCM cells (high gray levels amount, small window) automatically use SPARSE_MATRIX, which evaluates features
+over occupied cells only and gives the same results. SPARSE_MATRIX forces sparse GLCM for all windows. SUM_DIFF_HISTOGRAMS keeps
+only sum and difference histograms (2L - 1 bins each instead of L x L matrix), contrast and homogeneity are still exact,
+energy and entropy are approximated. Names of images calculated from histograms end with "_sumDiff" for exact features
+and "_sumDiffApprox" for approximated ones.
+@param storage - GLCM storage used for next calculations.
+*/
+void GLCM_features::setGLCMStorage(GLCMStorage storage) {
+	this->_storage = storage;
+}
+
+/*
+Select format of saved feature images. Features are always calculated with full precision, FLOAT_TIFF and FLOAT_NPY
+save them losslessly as 32-bit floats, QUANTIZED_GRAY_LEVELS scales them by 255 and snaps to gray levels of the source
+image before saving in its original format. STACKED_TIFF and STACKED_NPY save all images of one call into one
+multi-band file, see FeatureStack.
+@param outputFormat - format of saved feature images.
+*/
+void GLCM_features::setOutputFormat(FeatureImageFormat outputFormat) {
+	this->_outputFormat = outputFormat;
+}
+
+/*
+Select compression of STACKED_TIFF pages. Other formats are saved uncompressed.
+@param compression - compression of saved stacks.
+*/
+void GLCM_features::setStackCompression(StackCompression compression) {
+	this->_compression = compression;
+}
+
+/*
+Check if feature calculated with current GLCM storage is exact or only approximated.
+@param featureType - feature to check.
+@return true if feature is the same as calculated from full GLCM.
+*/
+bool GLCM_features::isFeatureExact(FeatureType featureType) {
+	if (this->_storage == FULL_MATRIX || this->_storage == SPARSE_MATRIX) {
+		return true;
+	}
+
+	return featureType == CONTRAST || featureType == HOMOGENEITY;
+}
+
+/*
+Limit SIMD instruction set used for evaluating features. By default the widest one supported by CPU is used.
+@param simdLevel - requested instruction set. Levels not supported by CPU are lowered to the supported one.
+*/
+void GLCM_features::setSimdLevel(SimdLevel simdLevel) {
+	this->_simdLevel = std::min(simdLevel, detectSimdLevel());
 }
 
 /*
 Check if given window size is valid - is it positive odd number that fits image sizes.
 If not, default window size will be used.
+@return valid window size.
 */
-void GLCM_features::validWindowSize(unsigned int windowSize) {
+unsigned int GLCM_features::validWindowSize(unsigned int windowSize) {
 	if (this->checkIfWindowSizeOdd(windowSize) &&
 		this->checkIfWindowSizeWithinImageSizes(windowSize)) {
-		this->_windowSize = windowSize;
-	}
-	else {
-		std::cerr << "Wrong window size. It has to be positive odd number that fits image sizes.\n";
-		this->_windowSize = DEFAULT_WINDOW_SIZE;
+		return windowSize;
 	}
+
+	std::cerr << "Wrong window size. It has to be positive odd number that fits image sizes.\n";
+	return DEFAULT_WINDOW_SIZE;
 }
 
 bool GLCM_features::checkIfWindowSizeOdd(unsigned int windowSize) {
@@ -42,172 +145,671 @@ bool GLCM_features::checkIfWindowSizeWithinImageSizes(unsigned int windowSize) {
 
 /**
 Create image of calculated energy from GLCM with given offset.
-@param offset - pair representing offset. Allowed values are: (1, 0), (0, 1), (1, 1), (-1, 1).
+@param offset - pair representing offset. Any non-zero (dx, dy).
 @param meanGLCM - row index of left top element of window.
 */
 void GLCM_features::energy(std::pair<int, int> offset) {
 	std::tuple<int, int, int, int> windowStartingValues = this->setStartingWindowParams();
-	this->calcFeatureFromGLCM(offset, ENERGY);
+	this->calcFeatureFromGLCM(offset, { ENERGY });
 }
 
 /**
 Create image of calculated energy from GLCM with given vector of offsets
-@param offsets - vector of pairs representing offsets. Allowed values are: (1, 0), (0, 1), (1, 1), (-1, 1).
+@param offsets - vector of pairs representing offsets. Any non-zero (dx, dy).
 @param meanGLCM - row index of left top element of window
 */
 void GLCM_features::energy(std::vector<std::pair<int, int>> offsets) {
-	this->calcFeatureFromGLCM(offsets, ENERGY);
+	this->calcFeatureFromGLCM(offsets, { ENERGY });
 }
 
 /**
 Create image of calculated entropy from GLCM with given offset.
-@param offset - pair representing offset. Allowed values are: (1, 0), (0, 1), (1, 1), (-1, 1).
+@param offset - pair representing offset. Any non-zero (dx, dy).
 @param meanGLCM - row index of left top element of window.
 */
 void GLCM_features::entropy(std::pair<int, int> offset) {
 	std::tuple<int, int, int, int> windowStartingValues = this->setStartingWindowParams();
-	this->calcFeatureFromGLCM(offset, ENTROPY);
+	this->calcFeatureFromGLCM(offset, { ENTROPY });
 }
 
 /**
 Create image of calculated entropy from GLCM with given vector of offsets
-@param offsets - vector of pairs representing offsets. Allowed values are: (1, 0), (0, 1), (1, 1), (-1, 1).
+@param offsets - vector of pairs representing offsets. Any non-zero (dx, dy).
 @param meanGLCM - row index of left top element of window
 */
 void GLCM_features::entropy(std::vector<std::pair<int, int>> offsets) {
-	this->calcFeatureFromGLCM(offsets, ENTROPY);
+	this->calcFeatureFromGLCM(offsets, { ENTROPY });
 }
 
 /**
 Create image of calculated contrast from GLCM with given offset.
-@param offset - pair representing offset. Allowed values are: (1, 0), (0, 1), (1, 1), (-1, 1).
+@param offset - pair representing offset. Any non-zero (dx, dy).
 @param meanGLCM - row index of left top element of window.
 */
 void GLCM_features::contrast(std::pair<int, int> offset) {
 	std::tuple<int, int, int, int> windowStartingValues = this->setStartingWindowParams();
-	this->calcFeatureFromGLCM(offset, CONTRAST);
+	this->calcFeatureFromGLCM(offset, { CONTRAST });
 }
 
 /**
 Create image of calculated contrast from GLCM with given vector of offsets
-@param offsets - vector of pairs representing offsets. Allowed values are: (1, 0), (0, 1), (1, 1), (-1, 1).
+@param offsets - vector of pairs representing offsets. Any non-zero (dx, dy).
 @param meanGLCM - row index of left top element of window
 */
 void GLCM_features::contrast(std::vector<std::pair<int, int>> offsets) {
-	this->calcFeatureFromGLCM(offsets, CONTRAST);
+	this->calcFeatureFromGLCM(offsets, { CONTRAST });
 }
 
 /**
 Create image of calculated homogeneity from GLCM with given offset.
-@param offset - pair representing offset. Allowed values are: (1, 0), (0, 1), (1, 1), (-1, 1).
+@param offset - pair representing offset. Any non-zero (dx, dy).
 @param meanGLCM - row index of left top element of window.
 */
 void GLCM_features::homogeneity(std::pair<int, int> offset) {
 	std::tuple<int, int, int, int> windowStartingValues = this->setStartingWindowParams();
-	this->calcFeatureFromGLCM(offset, HOMOGENEITY);
+	this->calcFeatureFromGLCM(offset, { HOMOGENEITY });
 }
 
 /**
 Create image of calculated homogeneity from GLCM with given vector of offsets
-@param offsets - vector of pairs representing offsets. Allowed values are: (1, 0), (0, 1), (1, 1), (-1, 1).
+@param offsets - vector of pairs representing offsets. Any non-zero (dx, dy).
 @param meanGLCM - row index of left top element of window
 */
 void GLCM_features::homogeneity(std::vector<std::pair<int, int>> offsets) {
-	this->calcFeatureFromGLCM(offsets, HOMOGENEITY);
+	this->calcFeatureFromGLCM(offsets, { HOMOGENEITY });
 }
 
-void GLCM_features::calcFeatureFromGLCM(std::pair<int, int> offset, FeatureType featureType) {
-	std::tuple<int, int, int, int> windowStartingValues = this->setStartingWindowParams();
-	int startingRow = std::get<0>(windowStartingValues);
-	int maxRow = std::get<1>(windowStartingValues);
-	int startingCol = std::get<2>(windowStartingValues);
-	int maxCol = std::get<3>(windowStartingValues);
-	std::unique_ptr<GLCM> glcm = std::make_unique<GLCM>(this->_image);
-	std::unique_ptr<Image> textureFeatureImage = std::make_unique<Image>(glcm->getImage());
+/**
+Create images of all given features from GLCM with given offset. GLCM of every window is calculated only once.
+@param offset - pair representing offset. Any non-zero (dx, dy).
+@param featureTypes - set of features to calculate.
+*/
+void GLCM_features::features(std::pair<int, int> offset, std::set<FeatureType> featureTypes) {
+	this->calcFeatureFromGLCM(offset, std::vector<FeatureType>(featureTypes.begin(), featureTypes.end()));
+}
+
+/**
+Create images of all given features from GLCM with given vector of offsets. Mean GLCM of every window is calculated only once.
+@param offsets - vector of pairs representing offsets. Any non-zero (dx, dy).
+@param featureTypes - set of features to calculate.
+*/
+void GLCM_features::features(std::vector<std::pair<int, int>> offsets, std::set<FeatureType> featureTypes) {
+	this->calcFeatureFromGLCM(offsets, std::vector<FeatureType>(featureTypes.begin(), featureTypes.end()));
+}
+
+void GLCM_features::calcFeatureFromGLCM(std::pair<int, int> offset, std::vector<FeatureType> featureTypes) {
 	std::string offsetAsString = "_offset(" + std::to_string(offset.first) + "," + std::to_string(offset.second) + ")";
-	std::string windowSizeAsString = "_windowSize_" + std::to_string(this->_windowSize);
-	std::string featureTypeAsString = this->stringifyFeatureType(featureType);
+	this->calcFeatureImages(std::vector<std::pair<int, int>>{ offset }, featureTypes, offsetAsString);
+}
+
+void GLCM_features::calcFeatureFromGLCM(std::vector<std::pair<int, int>> offsets, std::vector<FeatureType> featureTypes) {
+	std::string offsetAsString = "_mean_offset";
+	this->calcFeatureImages(offsets, featureTypes, offsetAsString);
+}
+
+/**
+Calculate images of all given features from GLCM with given offset without saving them.
+@param offset - pair representing offset. Any non-zero (dx, dy).
+@param featureTypes - set of features to calculate.
+@return named CV_32FC1 feature images, in order of featureTypes.
+*/
+std::vector<std::unique_ptr<Image>> GLCM_features::featureMaps(std::pair<int, int> offset, std::set<FeatureType> featureTypes) {
+	std::string offsetAsString = "_offset(" + std::to_string(offset.first) + "," + std::to_string(offset.second) + ")";
+	return this->calcFeatureMaps(std::vector<std::pair<int, int>>{ offset }, std::vector<FeatureType>(featureTypes.begin(), featureTypes.end()), offsetAsString);
+}
+
+/**
+Calculate images of all given features from mean GLCM with given vector of offsets without saving them.
+@param offsets - vector of pairs representing offsets. Any non-zero (dx, dy).
+@param featureTypes - set of features to calculate.
+@return named CV_32FC1 feature images, in order of featureTypes.
+*/
+std::vector<std::unique_ptr<Image>> GLCM_features::featureMaps(std::vector<std::pair<int, int>> offsets, std::set<FeatureType> featureTypes) {
+	std::string offsetAsString = "_mean_offset";
+	return this->calcFeatureMaps(offsets, std::vector<FeatureType>(featureTypes.begin(), featureTypes.end()), offsetAsString);
+}
+
+/*
+Calculate and save images of all given features.
+@param offsets - vector of pairs representing offsets. Single offset gives plain GLCM, more offsets give mean GLCM.
+@param featureTypes - features to calculate. One image is saved per feature, stacked formats save one file of all of them.
+@param offsetAsString - offset description used in names of saved images.
+*/
+void GLCM_features::calcFeatureImages(std::vector<std::pair<int, int>> offsets, std::vector<FeatureType> featureTypes, std::string offsetAsString) {
+	std::vector<std::unique_ptr<Image>> textureFeatureImages = this->calcFeatureMaps(offsets, featureTypes, offsetAsString);
+	if (this->_outputFormat == STACKED_TIFF || this->_outputFormat == STACKED_NPY) {
+		std::string grayLevelsAsString = "_grayLevels_" + std::to_string(this->_image->getImageInfo().grayLevelsAmount);
+		FeatureStack featureStack(this->_image->getImageInfo().imageName + "_features" + offsetAsString + grayLevelsAsString, textureFeatureImages.size(), this->_compression);
+		for (size_t n = 0; n < textureFeatureImages.size(); n++) {
+			featureStack.setBand(n, textureFeatureImages[n]);
+		}
+		featureStack.save(this->_outputFormat);
+		return;
+	}
+
+	for (auto& textureFeatureImage : textureFeatureImages) {
+		//textureFeatureImage->displayImage();
+		GLCM_features::saveFeatureImage(textureFeatureImage, this->_outputFormat);
+	}
+}
+
+/*
+Calculate images of all given features. GLCM of every window is calculated once and all features are evaluated from it.
+@param offsets - vector of pairs representing offsets. Single offset gives plain GLCM, more offsets give mean GLCM.
+@param featureTypes - features to calculate. One image is created per feature.
+@param offsetAsString - offset description used in names of images.
+@return named feature images, in order of featureTypes.
+*/
+std::vector<std::unique_ptr<Image>> GLCM_features::calcFeatureMaps(std::vector<std::pair<int, int>> offsets, std::vector<FeatureType> featureTypes, std::string offsetAsString) {
+	// rows of window centers, windows of the smallest size have centers in all rows of bigger ones
+	std::tuple<int, int, int, int> windowStartingValues = this->setStartingWindowParams();
+	int startingRow = std::get<0>(windowStartingValues) + this->_windowSize / 2;
+	int maxRow = std::get<1>(windowStartingValues) + this->_windowSize / 2;
 	std::string grayLevelsAsString = "_grayLevels_" + std::to_string(this->_image->getImageInfo().grayLevelsAmount);
-	std::string newImageName = textureFeatureImage->getImageInfo().imageName + featureTypeAsString + offsetAsString + windowSizeAsString + grayLevelsAsString;
-	textureFeatureImage->setImageName(newImageName);
 
-	for (int i = startingRow; i < maxRow; i++) {
-		for (int j = startingCol; j < maxCol; j++) {
-			
-			glcm->calculateGLCM(offset, i, j, this->_windowSize, false);
+	std::vector<std::unique_ptr<Image>> textureFeatureImages;
+	for (auto windowSize : this->_windowSizes) {
+		std::string windowSizeAsString = "_windowSize_" + std::to_string(windowSize);
+		for (auto featureType : featureTypes) {
+			std::unique_ptr<Image> textureFeatureImage = std::make_unique<Image>(this->_image);
+			std::string featureTypeAsString = this->stringifyFeatureType(featureType);
+			if (this->_storage == SUM_DIFF_HISTOGRAMS) {
+				featureTypeAsString += this->isFeatureExact(featureType) ? "_sumDiff" : "_sumDiffApprox";
+			}
+			std::string newImageName = textureFeatureImage->getImageInfo().imageName + featureTypeAsString + offsetAsString + windowSizeAsString + grayLevelsAsString;
+			textureFeatureImage->setImageName(newImageName);
+			textureFeatureImages.push_back(std::move(textureFeatureImage));
+		}
+	}
 
-			double result = 0.0;
-			switch(featureType) {
-				case ENERGY:
-					result = this->calcEnergy(glcm);
-					break;
-				case ENTROPY:
-					result = this->calcEntropy(glcm);
-					break;
-				case CONTRAST:
-					result = this->calcContrast(glcm);
-					break;
-				case HOMOGENEITY:
-					result = this->calcHomogeneity(glcm);
-					break;
-				default:
-					throw new BadFeatureType();
-					break;
+	this->prepareFeatureCalculation(offsets, featureTypes);
+
+	int rowsAmount = std::max(0, maxRow - startingRow);
+	int threadsAmount = std::min(static_cast<int>(this->_threadsAmount), rowsAmount);
+	if (threadsAmount <= 1) {
+		this->calcFeatureBand(offsets, featureTypes, textureFeatureImages, startingRow, maxRow);
+	}
+	else {
+		// every worker gets its own band of rows and its own GLCM, output pixels of bands do not overlap
+		std::vector<std::thread> workers;
+		std::vector<std::exception_ptr> errors(threadsAmount);
+		for (int t = 0; t < threadsAmount; t++) {
+			int firstRow = startingRow + rowsAmount * t / threadsAmount;
+			int lastRow = startingRow + rowsAmount * (t + 1) / threadsAmount;
+			workers.emplace_back([this, &offsets, &featureTypes, &textureFeatureImages, &errors, t, firstRow, lastRow]() {
+				try {
+					this->calcFeatureBand(offsets, featureTypes, textureFeatureImages, firstRow, lastRow);
+				}
+				catch (...) {
+					errors[t] = std::current_exception();
+				}
+			});
+		}
+
+		for (auto& worker : workers) {
+			worker.join();
+		}
+
+		for (auto& error : errors) {
+			if (error) {
+				std::rethrow_exception(error);
 			}
+		}
+	}
 
-			textureFeatureImage->setPixelValue(i + this->_windowSize / 2, j + this->_windowSize / 2, result);
+	return textureFeatureImages;
+}
+
+/*
+Check offsets and build entropy table for the biggest window before any window is calculated. Level indices of mapped
+raster are calculated here too, so its gray levels amount is validated before worker threads start.
+*/
+void GLCM_features::prepareFeatureCalculation(std::vector<std::pair<int, int>>& offsets, std::vector<FeatureType>& featureTypes) {
+	this->_image->getLevelIndexImage();
+
+	// offset longer than the smallest window has no pairs in it, but it has in bigger windows, so mean GLCM would
+	// mean different things for different window sizes
+	std::vector<unsigned long long> offsetWeights;
+	GLCM::calcOffsetWeights(offsets, this->_windowSize, this->_windowSize, false, offsetWeights);
+	if (std::find(offsetWeights.begin(), offsetWeights.end(), 0) != offsetWeights.end()) {
+		throw new BadOffset();
+	}
+
+	if (this->isEntropyNeeded(featureTypes)) {
+		std::unique_ptr<GLCM> glcm = std::make_unique<GLCM>(this->_image);
+		unsigned long long maxCount = glcm->calcWindowPairsAmount(offsets, this->_windowSizes.back(), false);
+		if (this->_featureWeights.countLogCount.size() != std::min<unsigned long long>(maxCount, MAX_ENTROPY_TABLE_COUNT) + 1) {
+			this->_featureWeights.countLogCount = makeCountLogCountTable(maxCount);
 		}
 	}
+}
+
+/**
+Calculate all given features from GLCM with given offset only at given pixels.
+@param offset - pair representing offset. Any non-zero (dx, dy).
+@param featureTypes - set of features to calculate.
+@param points - pixels to calculate, x is column and y is row. Windows of all sizes are centered at them.
+@return table with row per point and column per window size and feature.
+*/
+FeatureTable GLCM_features::featureTable(std::pair<int, int> offset, std::set<FeatureType> featureTypes, std::vector<cv::Point> points) {
+	return this->calcFeatureTable(std::vector<std::pair<int, int>>{ offset }, std::vector<FeatureType>(featureTypes.begin(), featureTypes.end()), points);
+}
+
+/**
+Calculate all given features from mean GLCM with given vector of offsets only at given pixels.
+@param offsets - vector of pairs representing offsets. Any non-zero (dx, dy).
+@param featureTypes - set of features to calculate.
+@param points - pixels to calculate, x is column and y is row. Windows of all sizes are centered at them.
+@return table with row per point and column per window size and feature.
+*/
+FeatureTable GLCM_features::featureTable(std::vector<std::pair<int, int>> offsets, std::set<FeatureType> featureTypes, std::vector<cv::Point> points) {
+	return this->calcFeatureTable(offsets, std::vector<FeatureType>(featureTypes.begin(), featureTypes.end()), points);
+}
+
+/**
+Calculate all given features from GLCM with given offset only at non-zero pixels of mask.
+@param offset - pair representing offset. Any non-zero (dx, dy).
+@param featureTypes - set of features to calculate.
+@param mask - CV_8UC1 image of the same size as the image.
+@return table with row per non-zero pixel of mask in row-major order and column per window size and feature.
+*/
+FeatureTable GLCM_features::featureTable(std::pair<int, int> offset, std::set<FeatureType> featureTypes, cv::Mat mask) {
+	return this->featureTable(offset, featureTypes, this->findMaskPoints(mask));
+}
+
+/**
+Calculate all given features from mean GLCM with given vector of offsets only at non-zero pixels of mask.
+@param offsets - vector of pairs representing offsets. Any non-zero (dx, dy).
+@param featureTypes - set of features to calculate.
+@param mask - CV_8UC1 image of the same size as the image.
+@return table with row per non-zero pixel of mask in row-major order and column per window size and feature.
+*/
+FeatureTable GLCM_features::featureTable(std::vector<std::pair<int, int>> offsets, std::set<FeatureType> featureTypes, cv::Mat mask) {
+	return this->featureTable(offsets, featureTypes, this->findMaskPoints(mask));
+}
+
+std::vector<cv::Point> GLCM_features::findMaskPoints(cv::Mat mask) {
+	if (mask.type() != CV_8UC1 || mask.rows != this->_image->getImageInfo().height || mask.cols != this->_image->getImageInfo().width) {
+		throw new BadMask();
+	}
+
+	std::vector<cv::Point> points;
+	for (int i = 0; i < mask.rows; i++) {
+		const uchar* maskRow = mask.ptr<uchar>(i);
+		for (int j = 0; j < mask.cols; j++) {
+			if (maskRow[j] != 0) {
+				points.push_back(cv::Point(j, i));
+			}
+		}
+	}
+
+	return points;
+}
 
-	//textureFeatureImage->displayImage();
+/*
+Calculate features of windows centered at given points. Values are the same as pixels of feature images calculated
+by sliding window, pixels where window does not fit have NaN. Computation mode is ignored, points are calculated in
+row-major order split between threads and GLCM of a point right of the previous one is slid instead of recalculated,
+so dense mask costs about as much as sliding window over the whole image.
+*/
+FeatureTable GLCM_features::calcFeatureTable(std::vector<std::pair<int, int>> offsets, std::vector<FeatureType> featureTypes, std::vector<cv::Point> points) {
+	std::vector<std::string> columnNames;
+	for (auto windowSize : this->_windowSizes) {
+		for (auto featureType : featureTypes) {
+			std::string columnName = this->stringifyFeatureType(featureType).substr(1);
+			if (this->_storage == SUM_DIFF_HISTOGRAMS) {
+				columnName += this->isFeatureExact(featureType) ? "_sumDiff" : "_sumDiffApprox";
+			}
+			columnNames.push_back(columnName + "_windowSize_" + std::to_string(windowSize));
+		}
+	}
+	FeatureTable featureTable(points, columnNames);
+	this->prepareFeatureCalculation(offsets, featureTypes);
+
+	std::vector<size_t> pointsOrder(points.size());
+	std::iota(pointsOrder.begin(), pointsOrder.end(), 0);
+	std::stable_sort(pointsOrder.begin(), pointsOrder.end(), [&points](size_t a, size_t b) {
+		return points[a].y < points[b].y || (points[a].y == points[b].y && points[a].x < points[b].x);
+	});
+
+	size_t pointsAmount = points.size();
+	size_t threadsAmount = std::min<size_t>(this->_threadsAmount, pointsAmount);
+	if (threadsAmount <= 1) {
+		this->calcFeatureTableRows(offsets, featureTypes, pointsOrder, 0, pointsAmount, featureTable);
+		return featureTable;
+	}
+
+	// every worker gets its own part of points and its own GLCMs, rows of table do not overlap
+	std::vector<std::thread> workers;
+	std::vector<std::exception_ptr> errors(threadsAmount);
+	for (size_t t = 0; t < threadsAmount; t++) {
+		size_t first = pointsAmount * t / threadsAmount;
+		size_t last = pointsAmount * (t + 1) / threadsAmount;
+		workers.emplace_back([this, &offsets, &featureTypes, &pointsOrder, &featureTable, &errors, t, first, last]() {
+			try {
+				this->calcFeatureTableRows(offsets, featureTypes, pointsOrder, first, last, featureTable);
+			}
+			catch (...) {
+				errors[t] = std::current_exception();
+			}
+		});
+	}
+
+	for (auto& worker : workers) {
+		worker.join();
+	}
+
+	for (auto& error : errors) {
+		if (error) {
+			std::rethrow_exception(error);
+		}
+	}
+
+	return featureTable;
+}
+
+/*
+Calculate table rows of points pointsOrder[first] ... pointsOrder[last - 1]. Every window size has its own GLCM,
+center of its last window decides whether the next one is slid or started again.
+*/
+void GLCM_features::calcFeatureTableRows(std::vector<std::pair<int, int>>& offsets, std::vector<FeatureType>& featureTypes, std::vector<size_t>& pointsOrder, size_t first, size_t last, FeatureTable& featureTable) {
+	std::vector<std::tuple<int, int, int, int>> centerRanges = this->calcWindowCenterRanges();
+	std::vector<cv::Point> points = featureTable.getPoints();
+	std::vector<std::unique_ptr<GLCM>> glcms;
+	for (int s = 0; s < this->_windowSizes.size(); s++) {
+		glcms.push_back(std::make_unique<GLCM>(this->_image, this->selectGLCMStorage(offsets, this->_windowSizes[s])));
+	}
+	std::vector<cv::Point> centers(this->_windowSizes.size(), cv::Point(-1, -1));
+	// timed once for all points, like rows of calcFeatureWithSlidingWindow()
+	GLCM_TIME_STAGE(STAGE_GLCM_ACCUMULATION);
+
+	for (size_t n = first; n < last; n++) {
+		size_t row = pointsOrder[n];
+		cv::Point point = points[row];
+		for (int s = 0; s < this->_windowSizes.size(); s++) {
+			int windowSize = this->_windowSizes[s];
+			// window sizes are sorted, bigger windows do not fit either
+			if (!this->checkIfWindowCenterCorrect(centerRanges[s], point.y, point.x)) {
+				break;
+			}
+
+			if (centers[s].y == point.y && centers[s].x == point.x - 1) {
+				glcms[s]->slideGLCMRight();
+			}
+			else {
+				glcms[s]->startSlidingGLCM(offsets, point.y - windowSize / 2, point.x - windowSize / 2, windowSize, false);
+			}
+			centers[s] = point;
+
+			std::vector<double> results = this->calcFeatures(glcms[s], featureTypes);
+			for (int f = 0; f < results.size(); f++) {
+				featureTable.setValue(static_cast<int>(row), static_cast<int>(s * featureTypes.size() + f), results[f]);
+			}
+		}
+	}
+}
+
+/**
+Save feature image in selected output format. Quantization to gray levels is done here, after all features are calculated.
+Single image of stacked format is saved as single band file of the same type. Uses no state of GLCM_features, so images returned by featureMaps() can be saved later by other threads.
+@param textureFeatureImage - feature image created by featureMaps().
+@param outputFormat - format of saved image, see setOutputFormat().
+*/
+void GLCM_features::saveFeatureImage(std::unique_ptr<Image>& textureFeatureImage, FeatureImageFormat outputFormat) {
+	switch(outputFormat) {
+		case FLOAT_TIFF:
+		case STACKED_TIFF:
+			textureFeatureImage->setExtension(".tiff");
+			break;
+		case FLOAT_NPY:
+		case STACKED_NPY:
+			textureFeatureImage->setExtension(".npy");
+			break;
+		case QUANTIZED_GRAY_LEVELS:
+			textureFeatureImage->quantizeToGrayLevels();
+			break;
+	}
 	textureFeatureImage->saveImage();
 }
 
-void GLCM_features::calcFeatureFromGLCM(std::vector<std::pair<int, int>> offsets, FeatureType featureType) {
+/*
+Calculate features of windows with center in rows <firstRow, lastRow). Uses own GLCMs, so bands can be calculated in parallel.
+Brute force calculates GLCM of the smallest window and grows it by rings into bigger windows with the same center.
+*/
+void GLCM_features::calcFeatureBand(std::vector<std::pair<int, int>>& offsets, std::vector<FeatureType>& featureTypes, std::vector<std::unique_ptr<Image>>& textureFeatureImages, int firstRow, int lastRow) {
+	if (this->_computationMode == SLIDING_WINDOW) {
+		this->calcFeatureWithSlidingWindow(offsets, featureTypes, textureFeatureImages, firstRow, lastRow);
+		return;
+	}
+	if (this->_computationMode == INTEGRAL_HISTOGRAMS) {
+		this->calcFeatureWithIntegralHistograms(offsets, featureTypes, textureFeatureImages, firstRow, lastRow);
+		return;
+	}
+	if (this->_computationMode == COLUMN_HISTOGRAMS) {
+		this->calcFeatureWithColumnHistograms(offsets, featureTypes, textureFeatureImages, firstRow, lastRow);
+		return;
+	}
+
 	std::tuple<int, int, int, int> windowStartingValues = this->setStartingWindowParams();
-	int startingRow = std::get<0>(windowStartingValues);
-	int maxRow = std::get<1>(windowStartingValues);
-	int startingCol = std::get<2>(windowStartingValues);
-	int maxCol = std::get<3>(windowStartingValues);
-	std::unique_ptr<GLCM> glcm = std::make_unique<GLCM>(this->_image);
-	std::unique_ptr<Image> textureFeatureImage = std::make_unique<Image>(glcm->getImage());
-	std::string offsetAsString = "_mean_offset";
-	std::string windowSizeAsString = "_windowSize_" + std::to_string(this->_windowSize);
-	std::string featureTypeAsString = this->stringifyFeatureType(featureType);
-	std::string grayLevelsAsString = "_grayLevels_" + std::to_string(this->_image->getImageInfo().grayLevelsAmount);
-	std::string newImageName = textureFeatureImage->getImageInfo().imageName + featureTypeAsString + offsetAsString + windowSizeAsString + grayLevelsAsString;
-	textureFeatureImage->setImageName(newImageName);
+	int startingCol = std::get<2>(windowStartingValues) + this->_windowSize / 2;
+	int maxCol = std::get<3>(windowStartingValues) + this->_windowSize / 2;
+	std::vector<std::tuple<int, int, int, int>> centerRanges = this->calcWindowCenterRanges();
+	// GLCM grows up to the biggest window
+	std::unique_ptr<GLCM> glcm = std::make_unique<GLCM>(this->_image, this->selectGLCMStorage(offsets, this->_windowSizes.back()));
 
-	for(int i = startingRow; i < maxRow; i++) {
-		for(int j = startingCol; j < maxCol; j++) {
+	for (int i = firstRow; i < lastRow; i++) {
+		for (int j = startingCol; j < maxCol; j++) {
+			for (int s = 0; s < this->_windowSizes.size(); s++) {
+				int windowSize = this->_windowSizes[s];
+				// window sizes are sorted, so bigger windows do not fit either
+				if (!this->checkIfWindowCenterCorrect(centerRanges[s], i, j)) {
+					break;
+				}
+
+				if (s == 0) {
+					glcm->startSlidingGLCM(offsets, i - windowSize / 2, j - windowSize / 2, windowSize, false);
+				}
+				else {
+					glcm->expandSlidingGLCM(windowSize);
+				}
+				this->setFeaturePixels(this->calcFeatures(glcm, featureTypes), textureFeatureImages, s * featureTypes.size(), i, j);
+			}
+		}
+	}
+}
 
-			glcm->calculateMeanGLCM(offsets, i, j, this->_windowSize, false);
+/*
+Move windows over the image in snake order (left to right, one row down, right to left, ...) and update their GLCMs
+incrementally. Every step costs O(windowSize) instead of O(windowSize^2) of recalculating whole GLCM. All window sizes
+are moved together in one traversal, every size has own GLCM and is moved only where it fits the image.
+*/
+void GLCM_features::calcFeatureWithSlidingWindow(std::vector<std::pair<int, int>>& offsets, std::vector<FeatureType>& featureTypes, std::vector<std::unique_ptr<Image>>& textureFeatureImages, int firstRow, int lastRow) {
+	std::tuple<int, int, int, int> windowStartingValues = this->setStartingWindowParams();
+	int startingCol = std::get<2>(windowStartingValues) + this->_windowSize / 2;
+	int maxCol = std::get<3>(windowStartingValues) + this->_windowSize / 2;
+	if (firstRow >= lastRow || startingCol >= maxCol) {
+		return;
+	}
 
-			double result = 0.0;
-			switch(featureType) {
-				case ENERGY:
-					result = this->calcEnergy(glcm);
-					break;
-				case ENTROPY:
-					result = this->calcEntropy(glcm);
-					break;
-				case CONTRAST:
-					result = this->calcContrast(glcm);
-					break;
-				case HOMOGENEITY:
-					result = this->calcHomogeneity(glcm);
-					break;
-				default:
-					throw new BadFeatureType();
+	std::vector<std::tuple<int, int, int, int>> centerRanges = this->calcWindowCenterRanges();
+	std::vector<std::unique_ptr<GLCM>> glcms;
+	for (int s = 0; s < this->_windowSizes.size(); s++) {
+		glcms.push_back(std::make_unique<GLCM>(this->_image, this->selectGLCMStorage(offsets, this->_windowSizes[s])));
+	}
+	std::vector<bool> started(this->_windowSizes.size(), false);
+	std::vector<bool> startedInRow(this->_windowSizes.size(), false);
+
+	for (int i = firstRow; i < lastRow; i++) {
+		// slides are not timed one by one, feature evaluation timed inside is not counted here
+		GLCM_TIME_STAGE(STAGE_GLCM_ACCUMULATION);
+		bool leftToRight = (i - firstRow) % 2 == 0;
+		std::fill(startedInRow.begin(), startedInRow.end(), false);
+
+		for (int step = 0; step < maxCol - startingCol; step++) {
+			int j = leftToRight ? startingCol + step : maxCol - 1 - step;
+			for (int s = 0; s < this->_windowSizes.size(); s++) {
+				int windowSize = this->_windowSizes[s];
+				// window sizes are sorted, so bigger windows do not fit either
+				if (!this->checkIfWindowCenterCorrect(centerRanges[s], i, j)) {
 					break;
+				}
+
+				// window ended previous row where it starts this one
+				if (!started[s]) {
+					glcms[s]->startSlidingGLCM(offsets, i - windowSize / 2, j - windowSize / 2, windowSize, false);
+					started[s] = true;
+				}
+				else if (!startedInRow[s]) {
+					glcms[s]->slideGLCMDown();
+				}
+				else if (leftToRight) {
+					glcms[s]->slideGLCMRight();
+				}
+				else {
+					glcms[s]->slideGLCMLeft();
+				}
+				startedInRow[s] = true;
+
+				this->setFeaturePixels(this->calcFeatures(glcms[s], featureTypes), textureFeatureImages, s * featureTypes.size(), i, j);
+			}
+		}
+	}
+}
+
+/*
+Calculate GLCMs from integral co-occurrence histograms. Cost of every window is O(offsets * codes) regardless of window
+size. Integral histograms of the whole band may not fit memory, so band is split into strips within
+DEFAULT_INTEGRAL_MEMORY_BUDGET shared by all threads, each strip covers its window centers with all their windows.
+When not even one window of the biggest size fits the budget, the band is calculated with sliding window, which gives
+the same results.
+*/
+void GLCM_features::calcFeatureWithIntegralHistograms(std::vector<std::pair<int, int>>& offsets, std::vector<FeatureType>& featureTypes, std::vector<std::unique_ptr<Image>>& textureFeatureImages, int firstRow, int lastRow) {
+	std::tuple<int, int, int, int> windowStartingValues = this->setStartingWindowParams();
+	int startingCol = std::get<2>(windowStartingValues) + this->_windowSize / 2;
+	int maxCol = std::get<3>(windowStartingValues) + this->_windowSize / 2;
+	if (firstRow >= lastRow || startingCol >= maxCol) {
+		return;
+	}
+
+	int maxWindowSize = this->_windowSizes.back();
+	unsigned long long rowMemorySize = IntegralGLCM::calcRowMemorySize(this->_image->getImageInfo().width, this->_image->getImageInfo().grayLevelsAmount, offsets.size(), this->_storage);
+	unsigned long long stripRowsAmount = DEFAULT_INTEGRAL_MEMORY_BUDGET / this->_threadsAmount / rowMemorySize;
+	// strip has to hold at least one window of the biggest size
+	if (stripRowsAmount < static_cast<unsigned long long>(maxWindowSize)) {
+		this->calcFeatureWithSlidingWindow(offsets, featureTypes, textureFeatureImages, firstRow, lastRow);
+		return;
+	}
+	int stripCentersAmount = static_cast<int>(std::min<unsigned long long>(stripRowsAmount - maxWindowSize + 1, lastRow - firstRow));
+
+	std::vector<std::tuple<int, int, int, int>> centerRanges = this->calcWindowCenterRanges();
+
+	for (int stripFirstRow = firstRow; stripFirstRow < lastRow; stripFirstRow += stripCentersAmount) {
+		int stripLastRow = std::min(lastRow, stripFirstRow + stripCentersAmount);
+		std::unique_ptr<IntegralGLCM> integralGLCM = std::make_unique<IntegralGLCM>(this->_image, offsets, stripFirstRow - maxWindowSize / 2, stripLastRow + maxWindowSize / 2, this->_storage, false);
+
+		for (int i = stripFirstRow; i < stripLastRow; i++) {
+			for (int j = startingCol; j < maxCol; j++) {
+				for (int s = 0; s < this->_windowSizes.size(); s++) {
+					int windowSize = this->_windowSizes[s];
+					// window sizes are sorted, so bigger windows do not fit either
+					if (!this->checkIfWindowCenterCorrect(centerRanges[s], i, j)) {
+						break;
+					}
+
+					integralGLCM->calculateGLCM(i - windowSize / 2, j - windowSize / 2, windowSize);
+					this->setFeaturePixels(this->calcFeatures(integralGLCM, featureTypes), textureFeatureImages, s * featureTypes.size(), i, j);
+				}
 			}
+		}
+	}
+}
 
-			textureFeatureImage->setPixelValue(i + this->_windowSize / 2, j + this->_windowSize / 2, result);
+/*
+Calculate GLCMs from co-occurrence histograms of columns. Windows go row by row from left to right, column histograms
+of every window size move down by one row and GLCM moves right by one column, both independently of window size.
+Column histograms of all window sizes have to fit DEFAULT_COLUMN_HISTOGRAMS_MEMORY_BUDGET shared by all threads,
+otherwise the band is calculated with sliding window, which gives the same results.
+*/
+void GLCM_features::calcFeatureWithColumnHistograms(std::vector<std::pair<int, int>>& offsets, std::vector<FeatureType>& featureTypes, std::vector<std::unique_ptr<Image>>& textureFeatureImages, int firstRow, int lastRow) {
+	std::tuple<int, int, int, int> windowStartingValues = this->setStartingWindowParams();
+	int startingCol = std::get<2>(windowStartingValues) + this->_windowSize / 2;
+	int maxCol = std::get<3>(windowStartingValues) + this->_windowSize / 2;
+	if (firstRow >= lastRow || startingCol >= maxCol) {
+		return;
+	}
+
+	unsigned long long memorySize = this->_windowSizes.size() * ColumnGLCM::calcMemorySize(this->_image->getImageInfo().width, this->_image->getImageInfo().grayLevelsAmount, offsets.size(), this->_storage);
+	if (memorySize > DEFAULT_COLUMN_HISTOGRAMS_MEMORY_BUDGET / this->_threadsAmount) {
+		this->calcFeatureWithSlidingWindow(offsets, featureTypes, textureFeatureImages, firstRow, lastRow);
+		return;
+	}
+
+	std::vector<std::tuple<int, int, int, int>> centerRanges = this->calcWindowCenterRanges();
+	std::vector<std::unique_ptr<ColumnGLCM>> columnGLCMs;
+	for (int s = 0; s < this->_windowSizes.size(); s++) {
+		columnGLCMs.push_back(std::make_unique<ColumnGLCM>(this->_image, offsets, this->_windowSizes[s], this->selectGLCMStorage(offsets, this->_windowSizes[s])));
+	}
+	std::vector<bool> startedInRow(this->_windowSizes.size(), false);
+
+	for (int i = firstRow; i < lastRow; i++) {
+		// timed per row, like calcFeatureWithSlidingWindow()
+		GLCM_TIME_STAGE(STAGE_GLCM_ACCUMULATION);
+		std::fill(startedInRow.begin(), startedInRow.end(), false);
+		for (int j = startingCol; j < maxCol; j++) {
+			for (int s = 0; s < this->_windowSizes.size(); s++) {
+				int windowSize = this->_windowSizes[s];
+				// window sizes are sorted, so bigger windows do not fit either
+				if (!this->checkIfWindowCenterCorrect(centerRanges[s], i, j)) {
+					break;
+				}
+
+				if (!startedInRow[s]) {
+					columnGLCMs[s]->startColumnGLCM(i - windowSize / 2, j - windowSize / 2);
+					startedInRow[s] = true;
+				}
+				else {
+					columnGLCMs[s]->slideGLCMRight();
+				}
+
+				this->setFeaturePixels(this->calcFeatures(columnGLCMs[s], featureTypes), textureFeatureImages, s * featureTypes.size(), i, j);
+			}
 		}
 	}
+}
 
-	//textureFeatureImage->displayImage();
-	textureFeatureImage->saveImage();
+/*
+Write evaluated features into given pixel of feature images.
+@param results - values of features, in order of feature images.
+@param firstImage - index of image of the first feature, images of the next features follow it.
+@param row, col - center of the window.
+*/
+void GLCM_features::setFeaturePixels(std::vector<double> results, std::vector<std::unique_ptr<Image>>& textureFeatureImages, int firstImage, int row, int col) {
+	for (int k = 0; k < results.size(); k++) {
+		textureFeatureImages[firstImage + k]->setPixelValue(row, col, results[k]);
+	}
+}
+
+/*
+Get ranges of centers of calculated windows of every window size. Windows start at left top corner of the image
+and their left top element stays before (image size - window size).
+@return first row, last row (exclusive), first column, last column (exclusive) of centers, in order of window sizes.
+*/
+std::vector<std::tuple<int, int, int, int>> GLCM_features::calcWindowCenterRanges() {
+	int width = this->_image->getImageInfo().width;
+	int height = this->_image->getImageInfo().height;
+
+	std::vector<std::tuple<int, int, int, int>> centerRanges;
+	for (auto windowSize : this->_windowSizes) {
+		int halfWindow = windowSize / 2;
+		centerRanges.push_back(std::make_tuple(halfWindow, height - static_cast<int>(windowSize) + halfWindow, halfWindow, width - static_cast<int>(windowSize) + halfWindow));
+	}
+
+	return centerRanges;
+}
+
+bool GLCM_features::checkIfWindowCenterCorrect(std::tuple<int, int, int, int>& centerRange, int row, int col) {
+	auto [firstRow, lastRow, firstCol, lastCol] = centerRange;
+	return row >= firstRow && row < lastRow && col >= firstCol && col < lastCol;
 }
 
 std::string GLCM_features::stringifyFeatureType(FeatureType featureType) {
@@ -230,53 +832,108 @@ std::string GLCM_features::stringifyFeatureType(FeatureType featureType) {
 	}
 }
 
-double GLCM_features::calcEnergy(std::unique_ptr<GLCM>& glcm) {
-	double result = 0.0;
-	for(int i = 0; i < glcm->getSize(); i++) {
-		for(int j = 0; j < glcm->getSize(); j++) {
-			result += std::pow(glcm->getGLCM()[i][j], 2);
-		}
+/*
+Evaluate all given features in one pass over GLCM, in the form given by storage of the GLCM.
+@return values of features in the same order as featureTypes.
+*/
+std::vector<double> GLCM_features::calcFeatures(std::unique_ptr<GLCM>& glcm, std::vector<FeatureType>& featureTypes) {
+	GLCM_TIME_STAGE(STAGE_FEATURE_EVALUATION);
+	GLCM_COUNT(COUNTER_WINDOWS, 1);
+	bool entropyNeeded = this->isEntropyNeeded(featureTypes);
+	switch (glcm->getStorage()) {
+		case SUM_DIFF_HISTOGRAMS:
+			return this->orderFeatureValues(calcSumDiffFeatureValues(glcm->getSumDiffHistograms(), this->_featureWeights, entropyNeeded), featureTypes);
+		case SPARSE_MATRIX:
+			return this->orderFeatureValues(calcSparseFeatureValues(glcm->getSparseGLCM(), this->_featureWeights, entropyNeeded), featureTypes);
+		default:
+			return this->orderFeatureValues(calcFeatureValues(glcm->getGLCM(), this->_featureWeights, entropyNeeded, this->_simdLevel), featureTypes);
 	}
-
-	return result;
 }
 
-double GLCM_features::calcEntropy(std::unique_ptr<GLCM>& glcm) {
-	double result = 0.0;
-	for(int i = 0; i < glcm->getSize(); i++) {
-		for(int j = 0; j < glcm->getSize(); j++) {
-			double glcmValue = glcm->getGLCM()[i][j];
-			if(glcmValue != 0.0) {
-				result += glcmValue * std::log(glcmValue);
-			}
-		}
+/*
+Evaluate all given features of the last queried window of integral histograms. SPARSE_MATRIX storage is queried as full matrix.
+@return values of features in the same order as featureTypes.
+*/
+std::vector<double> GLCM_features::calcFeatures(std::unique_ptr<IntegralGLCM>& integralGLCM, std::vector<FeatureType>& featureTypes) {
+	GLCM_TIME_STAGE(STAGE_FEATURE_EVALUATION);
+	GLCM_COUNT(COUNTER_WINDOWS, 1);
+	bool entropyNeeded = this->isEntropyNeeded(featureTypes);
+	if (this->_storage == SUM_DIFF_HISTOGRAMS) {
+		return this->orderFeatureValues(calcSumDiffFeatureValues(integralGLCM->getSumDiffHistograms(), this->_featureWeights, entropyNeeded), featureTypes);
 	}
 
-	result *= -1.0;
+	return this->orderFeatureValues(calcFeatureValues(integralGLCM->getGLCM(), this->_featureWeights, entropyNeeded, this->_simdLevel), featureTypes);
+}
+
+/*
+Evaluate all given features of the current window of column histograms. GLCM chosen to be sparse is kept as full matrix,
+it is evaluated with generic kernel, which gives the same results as sparse one.
+@return values of features in the same order as featureTypes.
+*/
+std::vector<double> GLCM_features::calcFeatures(std::unique_ptr<ColumnGLCM>& columnGLCM, std::vector<FeatureType>& featureTypes) {
+	GLCM_TIME_STAGE(STAGE_FEATURE_EVALUATION);
+	GLCM_COUNT(COUNTER_WINDOWS, 1);
+	bool entropyNeeded = this->isEntropyNeeded(featureTypes);
+	switch (columnGLCM->getStorage()) {
+		case SUM_DIFF_HISTOGRAMS:
+			return this->orderFeatureValues(calcSumDiffFeatureValues(columnGLCM->getSumDiffHistograms(), this->_featureWeights, entropyNeeded), featureTypes);
+		case SPARSE_MATRIX:
+			return this->orderFeatureValues(calcFeatureValuesGeneric(columnGLCM->getGLCM(), this->_featureWeights, entropyNeeded), featureTypes);
+		default:
+			return this->orderFeatureValues(calcFeatureValues(columnGLCM->getGLCM(), this->_featureWeights, entropyNeeded, this->_simdLevel), featureTypes);
+	}
+}
 
-	return result;
+bool GLCM_features::isEntropyNeeded(std::vector<FeatureType>& featureTypes) {
+	return std::find(featureTypes.begin(), featureTypes.end(), ENTROPY) != featureTypes.end();
 }
 
-double GLCM_features::calcContrast(std::unique_ptr<GLCM>& glcm) {
-	double result = 0.0;
-	for(int i = 0; i < glcm->getSize(); i++) {
-		for(int j = 0; j < glcm->getSize(); j++) {
-			result += glcm->getGLCM()[i][j] * std::pow(i - j, 2);
+/*
+Pick values of requested features.
+@return values of features in the same order as featureTypes.
+*/
+std::vector<double> GLCM_features::orderFeatureValues(FeatureValues values, std::vector<FeatureType>& featureTypes) {
+	std::vector<double> results;
+	for (auto featureType : featureTypes) {
+		switch(featureType) {
+			case ENERGY:
+				results.push_back(values.energy);
+				break;
+			case ENTROPY:
+				results.push_back(values.entropy);
+				break;
+			case CONTRAST:
+				results.push_back(values.contrast);
+				break;
+			case HOMOGENEITY:
+				results.push_back(values.homogeneity);
+				break;
+			default:
+				throw new BadFeatureType();
+				break;
 		}
 	}
 
-	return result;
+	return results;
 }
 
-double GLCM_features::calcHomogeneity(std::unique_ptr<GLCM>& glcm) {
-	double result = 0.0;
-	for(int i = 0; i < glcm->getSize(); i++) {
-		for(int j = 0; j < glcm->getSize(); j++) {
-			result += glcm->getGLCM()[i][j] / (1 + std::pow(i - j, 2));
-		}
+/*
+Choose storage of GLCM of windows with given size. Sparse GLCM pays for keeping list of occupied cells on every update,
+so FULL_MATRIX is switched to SPARSE_MATRIX only when the window has at least SPARSE_GLCM_CELLS_PER_PAIR GLCM cells
+for every pair it contains. Other storages are kept as selected.
+*/
+GLCMStorage GLCM_features::selectGLCMStorage(std::vector<std::pair<int, int>>& offsets, unsigned int windowSize) {
+	if (this->_storage != FULL_MATRIX) {
+		return this->_storage;
+	}
+
+	unsigned long long pairsAmount = 0;
+	for (auto offset : offsets) {
+		pairsAmount += GLCM::countPairsInRange(GLCM::getPairsRange(offset, 0, 0, windowSize, windowSize), false);
 	}
+	unsigned long long cellsAmount = static_cast<unsigned long long>(this->_image->getImageInfo().grayLevelsAmount) * this->_image->getImageInfo().grayLevelsAmount;
 
-	return result;
+	return pairsAmount * SPARSE_GLCM_CELLS_PER_PAIR <= cellsAmount ? SPARSE_MATRIX : FULL_MATRIX;
 }
 
 std::tuple<int, int, int, int> GLCM_features::setStartingWindowParams() {
@@ -0,0 +1,118 @@
+#include "../headers/grayLevelQuantizer.h"
+
+/**
+Count histogram of 8-bit pixels.
+@param pixels - 8-bit grayscale pixels. They are not copied and have to stay unchanged while quantizer is used.
+*/
+GrayLevelQuantizer::GrayLevelQuantizer(cv::Mat pixels) {
+	this->_pixels = pixels;
+	this->calculateHistogram();
+}
+
+/*
+Contiguous image is counted as one long row. Four partial histograms are filled in turns, so increments of
+neighbouring pixels with the same value do not wait for each other.
+*/
+void GrayLevelQuantizer::calculateHistogram() {
+	GLCM_TIME_STAGE(STAGE_REDUCE_GRAY_LEVELS);
+	std::array<std::array<unsigned long long, HISTOGRAM_BINS_AMOUNT>, 4> partialHistograms = {};
+	int rowsAmount = this->_pixels.isContinuous() ? 1 : this->_pixels.rows;
+	size_t rowLength = this->_pixels.isContinuous() ? this->_pixels.total() : this->_pixels.cols;
+
+	for (int i = 0; i < rowsAmount; i++) {
+		const uchar* pixelRow = this->_pixels.ptr<uchar>(i);
+		size_t j = 0;
+		for (; j + 4 <= rowLength; j += 4) {
+			partialHistograms[0][pixelRow[j]]++;
+			partialHistograms[1][pixelRow[j + 1]]++;
+			partialHistograms[2][pixelRow[j + 2]]++;
+			partialHistograms[3][pixelRow[j + 3]]++;
+		}
+		for (; j < rowLength; j++) {
+			partialHistograms[0][pixelRow[j]]++;
+		}
+	}
+
+	for (int value = 0; value < HISTOGRAM_BINS_AMOUNT; value++) {
+		this->_histogram[value] = partialHistograms[0][value] + partialHistograms[1][value] + partialHistograms[2][value] + partialHistograms[3][value];
+	}
+}
+
+cv::Mat GrayLevelQuantizer::createPixelTable(int grayLevelsAmount) {
+	int scale = std::ceil(static_cast<double>(HISTOGRAM_BINS_AMOUNT) / grayLevelsAmount);
+	cv::Mat table(1, HISTOGRAM_BINS_AMOUNT, CV_8UC1);
+	for (int value = 0; value < HISTOGRAM_BINS_AMOUNT; value++) {
+		table.at<uchar>(0, value) = static_cast<uchar>(value / scale * scale);
+	}
+
+	return table;
+}
+
+cv::Mat GrayLevelQuantizer::createLevelIndexTable(int grayLevelsAmount) {
+	int scale = std::ceil(static_cast<double>(HISTOGRAM_BINS_AMOUNT) / grayLevelsAmount);
+	cv::Mat table(1, HISTOGRAM_BINS_AMOUNT, CV_8UC1);
+	for (int value = 0; value < HISTOGRAM_BINS_AMOUNT; value++) {
+		table.at<uchar>(0, value) = static_cast<uchar>(value / scale);
+	}
+
+	return table;
+}
+
+/**
+Quantize pixels to given amount of gray levels.
+@param pixels - 8-bit grayscale pixels.
+@param grayLevelsAmount - target amount of gray levels, within (0, 255>.
+@param quantizedPixels - output pixels snapped to gray levels. Can be the same matrix as pixels to quantize in place.
+@param levelIndices - output indices of gray levels.
+*/
+void GrayLevelQuantizer::quantize(const cv::Mat& pixels, int grayLevelsAmount, cv::Mat& quantizedPixels, cv::Mat& levelIndices) {
+	GLCM_TIME_STAGE(STAGE_REDUCE_GRAY_LEVELS);
+	// level indices first, quantizing in place overwrites source pixels
+	cv::LUT(pixels, GrayLevelQuantizer::createLevelIndexTable(grayLevelsAmount), levelIndices);
+	cv::LUT(pixels, GrayLevelQuantizer::createPixelTable(grayLevelsAmount), quantizedPixels);
+}
+
+/**
+Quantize pixels to several amounts of gray levels in one pass. Blocks of rows are read once and quantized with tables
+of every amount of gray levels.
+@param grayLevelsAmounts - target amounts of gray levels, each within (0, 255>.
+@return quantized pixels and level indices, in order of grayLevelsAmounts.
+*/
+std::vector<QuantizedPixels> GrayLevelQuantizer::quantize(const std::vector<int>& grayLevelsAmounts) {
+	GLCM_TIME_STAGE(STAGE_REDUCE_GRAY_LEVELS);
+	std::vector<QuantizedPixels> quantizedImages;
+	std::vector<cv::Mat> pixelTables;
+	std::vector<cv::Mat> levelIndexTables;
+	for (auto grayLevelsAmount : grayLevelsAmounts) {
+		quantizedImages.push_back(QuantizedPixels{ grayLevelsAmount, cv::Mat(this->_pixels.rows, this->_pixels.cols, CV_8UC1), cv::Mat(this->_pixels.rows, this->_pixels.cols, CV_8UC1) });
+		pixelTables.push_back(GrayLevelQuantizer::createPixelTable(grayLevelsAmount));
+		levelIndexTables.push_back(GrayLevelQuantizer::createLevelIndexTable(grayLevelsAmount));
+	}
+
+	int blockRowsAmount = std::max(1, DEFAULT_QUANTIZATION_BLOCK_SIZE / std::max(1, this->_pixels.cols));
+	for (int firstRow = 0; firstRow < this->_pixels.rows; firstRow += blockRowsAmount) {
+		int lastRow = std::min(this->_pixels.rows, firstRow + blockRowsAmount);
+		cv::Mat block = this->_pixels.rowRange(firstRow, lastRow);
+		for (int k = 0; k < quantizedImages.size(); k++) {
+			// headers of blocks share data with whole images, so tables write straight into them
+			cv::Mat pixelsBlock = quantizedImages[k].pixels.rowRange(firstRow, lastRow);
+			cv::Mat levelIndicesBlock = quantizedImages[k].levelIndices.rowRange(firstRow, lastRow);
+			cv::LUT(block, pixelTables[k], pixelsBlock);
+			cv::LUT(block, levelIndexTables[k], levelIndicesBlock);
+		}
+	}
+
+	return quantizedImages;
+}
+
+/**
+Count distinct pixel values.
+@return amount of non-empty histogram bins.
+*/
+unsigned int GrayLevelQuantizer::countGrayLevels() {
+	return static_cast<unsigned int>(std::count_if(this->_histogram.begin(), this->_histogram.end(), [](unsigned long long count) { return count > 0; }));
+}
+
+std::array<unsigned long long, HISTOGRAM_BINS_AMOUNT> GrayLevelQuantizer::getHistogram() {
+	return this->_histogram;
+}
@@ -1,11 +1,14 @@
 #include "../headers/image.h"
 
+std::atomic<unsigned long long> Image::_allPairCodesMemorySize(0);
+
 /**
 Load image from disk in grayscale and reduce gray levels to given number.
 @param path - path to stored image.
 @param grayLevelsAmount - target amount of gray levels in read image.
 */
 Image::Image(std::string path, int grayLevelsAmount) {
+	this->_pairCodesMemorySize = 0;
 	this->_path = path;
 	this->_imageInfo.imageName = std::filesystem::path(this->_path).filename().replace_extension("").string();
 	this->_imageInfo.extension = std::filesystem::path(this->_path).extension().string();
@@ -20,15 +23,36 @@ Image::Image(std::string path, int grayLevelsAmount) {
 
 	this->_imageInfo.width = this->_img.cols;
 	this->_imageInfo.height = this->_img.rows;
-	if (this->isGrayLevelsAmountCorrect(grayLevelsAmount)) {
-		this->_imageInfo.grayLevelsAmount = grayLevelsAmount;
+	this->setGrayLevelsAmount(grayLevelsAmount);
+	this->calculateOriginalGrayLevelsAmount();
+
+	try {
+		this->reduceGrayLevels();
 	}
-	else {
-		std::cerr << "Wrong gray levels amount. It has to be a integer number within (0, 255> range.\n";
-		this->_imageInfo.grayLevelsAmount = DEFAULT_GRAY_LEVELS_AMOUNT;
+	catch (BadGrayLevels ex) {
+		std::cerr << ex.msg();
+		throw ex;
 	}
+}
 
-	this->calculateOriginalGrayLevelsAmount();
+/**
+Create image from already loaded pixels, e.g. strip of bigger image, and reduce gray levels to given number.
+@param path - path to the image pixels come from. Used for naming and output directory.
+@param pixels - 8-bit grayscale pixels. Reducing gray levels changes them in place.
+@param grayLevelsAmount - target amount of gray levels.
+@param originalGrayLevelsAmount - amount of gray levels of the whole source image, used to validate grayLevelsAmount.
+*/
+Image::Image(std::string path, cv::Mat pixels, int grayLevelsAmount, unsigned int originalGrayLevelsAmount) {
+	this->_pairCodesMemorySize = 0;
+	this->_path = path;
+	this->_imageInfo.imageName = std::filesystem::path(this->_path).filename().replace_extension("").string();
+	this->_imageInfo.extension = std::filesystem::path(this->_path).extension().string();
+	this->_img = pixels;
+
+	this->_imageInfo.width = this->_img.cols;
+	this->_imageInfo.height = this->_img.rows;
+	this->setGrayLevelsAmount(grayLevelsAmount);
+	this->_imageInfo.originalGrayLevelsAmount = originalGrayLevelsAmount;
 
 	try {
 		this->reduceGrayLevels();
@@ -39,6 +63,42 @@ Image::Image(std::string path, int grayLevelsAmount) {
 	}
 }
 
+/**
+Create image from pixels already quantized by GrayLevelQuantizer, e.g. one of several gray levels amounts of the same source.
+@param path - path to the image pixels come from. Used for naming and output directory.
+@param quantizedPixels - pixels and level indices quantized to their amount of gray levels.
+@param originalGrayLevelsAmount - amount of gray levels of the source image, used to validate amount of gray levels.
+*/
+Image::Image(std::string path, QuantizedPixels quantizedPixels, unsigned int originalGrayLevelsAmount) {
+	this->_pairCodesMemorySize = 0;
+	this->_path = path;
+	this->_imageInfo.imageName = std::filesystem::path(this->_path).filename().replace_extension("").string();
+	this->_imageInfo.extension = std::filesystem::path(this->_path).extension().string();
+	this->_img = quantizedPixels.pixels;
+	this->_levelIndices = quantizedPixels.levelIndices;
+
+	this->_imageInfo.width = this->_img.cols;
+	this->_imageInfo.height = this->_img.rows;
+	this->_imageInfo.grayLevelsAmount = quantizedPixels.grayLevelsAmount;
+	this->_imageInfo.originalGrayLevelsAmount = originalGrayLevelsAmount;
+
+	if (!this->isGrayLevelCorrect()) {
+		std::cerr << BadGrayLevels().msg();
+		throw new BadGrayLevels();
+	}
+	this->calculateGrayLevels();
+}
+
+void Image::setGrayLevelsAmount(int grayLevelsAmount) {
+	if (this->isGrayLevelsAmountCorrect(grayLevelsAmount)) {
+		this->_imageInfo.grayLevelsAmount = grayLevelsAmount;
+	}
+	else {
+		std::cerr << "Wrong gray levels amount. It has to be a integer number within (0, 255> range.\n";
+		this->_imageInfo.grayLevelsAmount = DEFAULT_GRAY_LEVELS_AMOUNT;
+	}
+}
+
 bool Image::isGrayLevelsAmountCorrect(int grayLevelsAmount) {
 	if (grayLevelsAmount > 0 && grayLevelsAmount < 256) {
 		return true;
@@ -47,6 +107,7 @@ bool Image::isGrayLevelsAmountCorrect(int grayLevelsAmount) {
 }
 
 void Image::loadImageInGrayScale() {
+	GLCM_TIME_STAGE(STAGE_LOAD_IMAGE);
 	this->_img = cv::imread(this->_path, cv::IMREAD_GRAYSCALE);
 	if (this->_img.empty()) {
 		std::cerr << "Error: Unable to load the image." << std::endl;
@@ -55,27 +116,68 @@ void Image::loadImageInGrayScale() {
 }
 
 void Image::calculateOriginalGrayLevelsAmount() {
-	std::set<uchar>uniqueLevels(this->_img.begin<uchar>(), this->_img.end<uchar>());
-	this->_imageInfo.originalGrayLevelsAmount = static_cast<int>(uniqueLevels.size());
+	GrayLevelQuantizer quantizer(this->_img);
+	this->_imageInfo.originalGrayLevelsAmount = quantizer.countGrayLevels();
 }
 
+/*
+Quantize pixels in place and calculate level indices with lookup tables.
+*/
 void Image::reduceGrayLevels() {
 	if (!this->isGrayLevelCorrect()) {
 		throw new BadGrayLevels();
 	}
 
+	this->calculateGrayLevels();
+	GrayLevelQuantizer::quantize(this->_img, this->_imageInfo.grayLevelsAmount, this->_img, this->_levelIndices);
+}
+
+void Image::calculateGrayLevels() {
 	int scale = std::ceil(static_cast<double>(MAX_PIXEL_VALUE) / this->_imageInfo.grayLevelsAmount);
 	for(int i = 0; i < MAX_PIXEL_VALUE; i += scale) {
 		this->_imageInfo.grayLevels.push_back(i);
 	}
+}
 
+/*
+Fill level indices of memory mapped raster in one pass, validating gray levels amount on the way. Mapped pixels are
+read-only, so they are not quantized in place. 16-bit pixels are split into levels over range of raster max value.
+*/
+void Image::reduceMappedGrayLevels() {
+	GLCM_TIME_STAGE(STAGE_REDUCE_GRAY_LEVELS);
+	unsigned int maxValue = this->_raster->getMaxValue();
+	unsigned int scale = (maxValue + this->_imageInfo.grayLevelsAmount) / this->_imageInfo.grayLevelsAmount;
+	unsigned int maxLevelIndex = this->_imageInfo.grayLevelsAmount - 1;
+	bool bigEndian = this->_raster->isBigEndian();
+	std::vector<bool> usedValues(this->_img.depth() == CV_16U ? 65536 : 256, false);
+
+	cv::Mat levelIndices(this->_imageInfo.height, this->_imageInfo.width, CV_8UC1);
 	for (int i = 0; i < this->_imageInfo.height; ++i) {
-		for (int j = 0; j < this->_imageInfo.width; ++j) {
-			int originalPixelValue = this->_img.at<uchar>(i, j);
-			int newPixelValue = static_cast<int>((originalPixelValue / scale) * scale);
-			this->_img.at<uchar>(i, j) = static_cast<uchar>(newPixelValue);
+		uchar* levelIndexRow = levelIndices.ptr<uchar>(i);
+		if (this->_img.depth() == CV_16U) {
+			const ushort* pixelRow = this->_img.ptr<ushort>(i);
+			for (int j = 0; j < this->_imageInfo.width; ++j) {
+				unsigned int value = bigEndian ? static_cast<ushort>((pixelRow[j] >> 8) | (pixelRow[j] << 8)) : pixelRow[j];
+				usedValues[value] = true;
+				levelIndexRow[j] = static_cast<uchar>(std::min(value / scale, maxLevelIndex));
+			}
+		}
+		else {
+			const uchar* pixelRow = this->_img.ptr<uchar>(i);
+			for (int j = 0; j < this->_imageInfo.width; ++j) {
+				usedValues[pixelRow[j]] = true;
+				levelIndexRow[j] = static_cast<uchar>(std::min(pixelRow[j] / scale, maxLevelIndex));
+			}
 		}
-	}	
+	}
+
+	// image info keeps header bound of original gray levels, it may be read by other threads meanwhile
+	unsigned int usedValuesAmount = static_cast<unsigned int>(std::count(usedValues.begin(), usedValues.end(), true));
+	if (this->_imageInfo.grayLevelsAmount > usedValuesAmount) {
+		std::cerr << BadGrayLevels().msg();
+		throw new BadGrayLevels();
+	}
+	this->_levelIndices = levelIndices;
 }
 
 bool Image::isGrayLevelCorrect() {
@@ -90,8 +192,10 @@ bool Image::isGrayLevelCorrect() {
 /**
 Create image with size and grey levels amount equal to given image.
 @param image - existing image.
+@param matType - type of pixels. Feature images are kept as CV_32FC1 so calculated values are not rounded.
 */
-Image::Image(std::shared_ptr<Image> image) {
+Image::Image(std::shared_ptr<Image> image, int matType) {
+	this->_pairCodesMemorySize = 0;
 	this->_imageInfo.imageName = image->getImageInfo().imageName;
 	this->_imageInfo.extension = image->getImageInfo().extension;
 	this->_imageInfo.width = image->getImageInfo().width;
@@ -104,7 +208,41 @@ Image::Image(std::shared_ptr<Image> image) {
 	directoryPath = directoryPath.erase(directoryPath.rfind(delimiter)) + delimiter + "output/";
 	this->_path = directoryPath;
 
-	this->_img = cv::Mat(this->_imageInfo.height, this->_imageInfo.width, CV_8UC1, cv::Scalar(0, 0, 0));
+	this->_img = cv::Mat(this->_imageInfo.height, this->_imageInfo.width, matType, cv::Scalar(0, 0, 0));
+}
+
+/**
+Create image of memory mapped raster. Pixels are not copied, level indices are calculated on first use, so creating
+image does not read the raster. Image info is given by raster header, original gray levels amount is bounded by its max
+value. Values used by pixels are counted and gray levels amount is validated against them together with level indices,
+on first call of getLevelIndexImage().
+@param raster - mapped PGM or raw file.
+@param grayLevelsAmount - target amount of gray levels.
+*/
+Image::Image(std::shared_ptr<MappedRaster> raster, int grayLevelsAmount) {
+	this->_pairCodesMemorySize = 0;
+	this->_raster = raster;
+	this->_path = raster->getPath();
+	this->_imageInfo.imageName = std::filesystem::path(this->_path).filename().replace_extension("").string();
+	this->_imageInfo.extension = std::filesystem::path(this->_path).extension().string();
+	this->_img = raster->getPixels();
+
+	this->_imageInfo.width = this->_img.cols;
+	this->_imageInfo.height = this->_img.rows;
+	this->setGrayLevelsAmount(grayLevelsAmount);
+	this->_imageInfo.originalGrayLevelsAmount = std::min<unsigned int>(raster->getMaxValue() + 1, this->_img.depth() == CV_16U ? 65536 : 256);
+	if (!this->isGrayLevelCorrect()) {
+		std::cerr << BadGrayLevels().msg();
+		throw new BadGrayLevels();
+	}
+	this->calculateGrayLevels();
+}
+
+/**
+Give memory of pair code images back to budget shared by all images.
+*/
+Image::~Image() {
+	Image::_allPairCodesMemorySize -= this->_pairCodesMemorySize;
 }
 
 bool Image::isImageSizesCorrect(int width, int height) {
@@ -115,8 +253,10 @@ bool Image::isImageSizesCorrect(int width, int height) {
 }
 
 /**
-Create image with size and grey levels amount equal to given image.
-@param image - existing image.
+Set gray scale value of 8-bit image pixel.
+@param x - row of the pixel.
+@param y - column of the pixel.
+@param value - new pixel value.
 */
 void Image::setPixelValue(int x, int y, int value) {
 	if (this->isPixelCoordsCorrect(x, y)) {
@@ -128,26 +268,60 @@ void Image::setPixelValue(int x, int y, int value) {
 }
 
 /**
-Create image with size and grey levels amount equal to given image.
-@param image - existing image.
+Set feature value of the pixel. Float images keep value as it is, 8-bit images get it scaled by 255
+and snapped to the nearest gray level.
+@param x - row of the pixel.
+@param y - column of the pixel.
+@param value - feature value.
 */
 void Image::setPixelValue(int x, int y, double value) {
+	if (this->_img.depth() == CV_32F) {
+		if (this->isPixelCoordsCorrect(x, y)) {
+			this->_img.at<float>(x, y) = static_cast<float>(value);
+		}
+		else {
+			std::cerr << "Wrong pixel coords to change. Can't do anything.\n";
+		}
+		return;
+	}
+
 	int valueToGrayScale = this->convertDoubleValueToGrayScale(value);
 	this->setPixelValue(x, y, valueToGrayScale);
 }
 
 bool Image::isPixelCoordsCorrect(int x, int y) {
-	if ((x >= 0 && x <= this->_imageInfo.height) && (y >= 0 && y <= this->_imageInfo.width)) {
+	if ((x >= 0 && x < this->_imageInfo.height) && (y >= 0 && y < this->_imageInfo.width)) {
 		return true;
 	}
 	return false;
 }
 
+/**
+Convert float feature image into 8-bit image with values scaled by 255 and snapped to the nearest gray level.
+Optional step before saving, it loses precision of calculated features. Does nothing for 8-bit images.
+*/
+void Image::quantizeToGrayLevels() {
+	if (this->_img.depth() != CV_32F) {
+		return;
+	}
+
+	cv::Mat quantized(this->_imageInfo.height, this->_imageInfo.width, CV_8UC1);
+	for (int i = 0; i < this->_imageInfo.height; ++i) {
+		const float* featureRow = this->_img.ptr<float>(i);
+		uchar* pixelRow = quantized.ptr<uchar>(i);
+		for (int j = 0; j < this->_imageInfo.width; ++j) {
+			pixelRow[j] = static_cast<uchar>(this->convertDoubleValueToGrayScale(featureRow[j]));
+		}
+	}
+	this->_img = quantized;
+}
+
 /**
 Save image on disk. Remember to previously set proper image name and path.
+Images with ".npy" extension are saved as NumPy arrays, other formats are handled by OpenCV.
 */
 void Image::saveImage() {
-	bool check = cv::imwrite(this->_path, this->_img);
+	bool check = this->_imageInfo.extension == ".npy" ? this->saveNpy() : this->saveEncoded();
 	if(check) {
 		std::cout << "Successfully saved " + this->_imageInfo.imageName + this->_imageInfo.extension << std::endl;
 	}
@@ -164,25 +338,64 @@ int Image::convertDoubleValueToGrayScale(double value) {
 	return grayScaleValue;
 }
 
+/*
+Gray levels are multiples of the same step, so the nearest one is found by rounding instead of searching.
+Ties go to the lower level.
+*/
 int Image::convertIntValueToGrayLevel(int value) {
-	int nearestGrayScaleValueFromLevels = INT_MAX;
-	int smallestDifference = INT_MAX;
-	for(auto greyLevel : this->_imageInfo.grayLevels) {
-		int difference = std::abs(value - static_cast<int>(greyLevel));
-		if(difference < smallestDifference) {
-			smallestDifference = difference;
-			nearestGrayScaleValueFromLevels = static_cast<int>(greyLevel);
-		}
+	int levelsAmount = static_cast<int>(this->_imageInfo.grayLevels.size());
+	int scale = levelsAmount > 1 ? static_cast<int>(this->_imageInfo.grayLevels[1]) : MAX_PIXEL_VALUE;
+	int levelIndex = std::min((std::max(value, 0) + (scale - 1) / 2) / scale, levelsAmount - 1);
+
+	return static_cast<int>(this->_imageInfo.grayLevels[levelIndex]);
+}
+
+/*
+Encode image with OpenCV in format given by extension.
+*/
+bool Image::saveEncoded() {
+	GLCM_TIME_STAGE(STAGE_SAVE_IMAGE);
+	bool saved = cv::imwrite(this->_path, this->_img);
+	if (saved) {
+		GLCM_COUNT_FILE_BYTES(this->_path);
+	}
+
+	return saved;
+}
+
+/*
+Write float image as NumPy .npy file.
+*/
+bool Image::saveNpy() {
+	if (this->_img.depth() != CV_32F) {
+		return false;
 	}
 
-	return nearestGrayScaleValueFromLevels;
+	StripWriter writer(this->_path, this->_img.rows, this->_img.cols, CV_32FC1);
+	writer.writeRows(this->_img, 0, this->_img.rows);
+
+	return writer.isGood() && writer.isComplete();
 }
 
 /**
 Display image in dedicate window.
 */
 void Image::displayImage() {
-	cv::imshow(this->_imageInfo.imageName, this->_img);
+	if (this->_img.depth() == CV_16U) {
+		// 16-bit pixels may be big-endian and use only part of the range, so they are scaled by raster max value
+		unsigned int maxValue = std::max(1u, this->_raster ? this->_raster->getMaxValue() : USHRT_MAX);
+		cv::Mat displayed(this->_img.rows, this->_img.cols, CV_8UC1);
+		for (int i = 0; i < this->_img.rows; i++) {
+			uchar* displayedRow = displayed.ptr<uchar>(i);
+			for (int j = 0; j < this->_img.cols; j++) {
+				displayedRow[j] = static_cast<uchar>(std::min(this->readPixelValue(i, j), maxValue) * UCHAR_MAX / maxValue);
+			}
+		}
+		cv::imshow(this->_imageInfo.imageName, displayed);
+	}
+	else {
+		cv::imshow(this->_imageInfo.imageName, this->_img);
+	}
 	cv::waitKey(0);
 	cv::destroyAllWindows();
 }
@@ -194,14 +407,33 @@ void Image::printImage() {
 	std::cout << "Image values" << std::endl;
 	for (int i = 0; i < this->_imageInfo.height; i++) {
 		for (int j = 0; j < this->_imageInfo.width; j++) {
-			uchar pixelValue = this->_img.at<uchar>(i, j);
-			std::cout << std::setw(3) << static_cast<int>(pixelValue) << " ";
+			if (this->_img.depth() == CV_32F) {
+				std::cout << std::setw(9) << this->_img.at<float>(i, j) << " ";
+			}
+			else {
+				std::cout << std::setw(this->_img.depth() == CV_16U ? 5 : 3) << this->readPixelValue(i, j) << " ";
+			}
 		}
 		std::cout << std::endl;
 	}
 	std::cout << std::endl;
 }
 
+/*
+Read value of 8-bit or 16-bit pixel. 16-bit pixels of big-endian rasters are swapped.
+*/
+unsigned int Image::readPixelValue(int i, int j) {
+	if (this->_img.depth() != CV_16U) {
+		return this->_img.at<uchar>(i, j);
+	}
+
+	ushort pixelValue = this->_img.at<ushort>(i, j);
+	if (this->_raster && this->_raster->isBigEndian()) {
+		pixelValue = static_cast<ushort>((pixelValue >> 8) | (pixelValue << 8));
+	}
+	return pixelValue;
+}
+
 /**
 Get struct with basic image data
 @return Image data struct.
@@ -218,6 +450,66 @@ cv::Mat Image::getImage() {
 	return this->_img;
 }
 
+/**
+Get image with indices of gray levels (0..grayLevelsAmount - 1) instead of pixel values.
+Calculated once with reducing gray levels, so GLCM can use pixel values directly as matrix indices.
+Memory mapped rasters get level indices calculated on first call.
+@return Level index matrix. Empty for images not loaded from disk.
+*/
+cv::Mat Image::getLevelIndexImage() {
+	if (this->_raster) {
+		std::call_once(this->_levelIndicesFlag, [this]() { this->reduceMappedGrayLevels(); });
+	}
+	return this->_levelIndices;
+}
+
+/**
+Get image of pair codes for given offset. Pixel (i, j) keeps code levelIndex(i, j) * L + levelIndex(i + dy, j + dx)
+of pair with first pixel in (i, j), pixels without neighbour inside the image keep 0. GLCM counts pairs with one
+read per pair and no neighbour addressing. Calculated once per offset and shared by all GLCMs of the image.
+@param offset - pair representing offset (dx, dy).
+@return CV_16UC1 image of pair codes. Empty when codes would not fit DEFAULT_PAIR_CODES_MEMORY_BUDGET shared by all images.
+*/
+cv::Mat Image::getPairCodeImage(std::pair<int, int> offset) {
+	std::lock_guard<std::mutex> lock(this->_pairCodesMutex);
+	auto pairCodes = this->_pairCodes.find(offset);
+	if (pairCodes != this->_pairCodes.end()) {
+		return pairCodes->second;
+	}
+
+	// budget is shared by all images, so images waiting in batch queue can't multiply it
+	unsigned long long memorySize = static_cast<unsigned long long>(this->_imageInfo.width) * this->_imageInfo.height * sizeof(ushort);
+	if (Image::_allPairCodesMemorySize.fetch_add(memorySize) + memorySize > DEFAULT_PAIR_CODES_MEMORY_BUDGET) {
+		Image::_allPairCodesMemorySize -= memorySize;
+		return cv::Mat();
+	}
+
+	this->_pairCodesMemorySize += memorySize;
+	this->_pairCodes[offset] = this->calculatePairCodeImage(offset);
+	return this->_pairCodes[offset];
+}
+
+cv::Mat Image::calculatePairCodeImage(std::pair<int, int> offset) {
+	cv::Mat levelIndices = this->getLevelIndexImage();
+	int width = levelIndices.cols;
+	int height = levelIndices.rows;
+	cv::Mat pairCodes = cv::Mat::zeros(height, width, CV_16UC1);
+	int firstRow = std::max(0, -offset.second);
+	int lastRow = height - std::max(0, offset.second);
+	int firstCol = std::max(0, -offset.first);
+	int lastCol = width - std::max(0, offset.first);
+	for (int i = firstRow; i < lastRow; i++) {
+		const uchar* currentRow = levelIndices.ptr<uchar>(i);
+		const uchar* neighbourRow = levelIndices.ptr<uchar>(i + offset.second) + offset.first;
+		ushort* pairCodeRow = pairCodes.ptr<ushort>(i);
+		for (int j = firstCol; j < lastCol; j++) {
+			pairCodeRow[j] = static_cast<ushort>(currentRow[j] * this->_imageInfo.grayLevelsAmount + neighbourRow[j]);
+		}
+	}
+
+	return pairCodes;
+}
+
 /**
 Get image path.
 @return Path to the image.
@@ -234,3 +526,12 @@ void Image::setImageName(std::string name) {
 	this->_imageInfo.imageName = std::filesystem::path(name).replace_extension("").string();
 	this->_path = std::filesystem::path(this->_path).replace_filename(name).string() + this->_imageInfo.extension;
 }
+
+/**
+Set new extension of the image. It decides in which format image is saved. Also update image path.
+@param extension - new extension with leading dot, e.g. ".tiff".
+*/
+void Image::setExtension(std::string extension) {
+	this->_path = std::filesystem::path(this->_path).replace_filename(this->_imageInfo.imageName).string() + extension;
+	this->_imageInfo.extension = extension;
+}
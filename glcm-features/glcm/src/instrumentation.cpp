@@ -0,0 +1,132 @@
+#include "../headers/instrumentation.h"
+
+std::mutex Instrumentation::_mutex;
+InstrumentationTotals Instrumentation::_totals{};
+
+Instrumentation::ThreadTotals::~ThreadTotals() {
+	Instrumentation::merge(this->totals);
+}
+
+InstrumentationTotals& Instrumentation::threadTotals() {
+	thread_local ThreadTotals threadTotals;
+	return threadTotals.totals;
+}
+
+/*
+Add totals of one thread to process totals and clear them.
+*/
+void Instrumentation::merge(InstrumentationTotals& totals) {
+	std::lock_guard<std::mutex> lock(Instrumentation::_mutex);
+	for (int stage = 0; stage < STAGES_AMOUNT; stage++) {
+		Instrumentation::_totals.stageNs[stage] += totals.stageNs[stage];
+		Instrumentation::_totals.stageCalls[stage] += totals.stageCalls[stage];
+	}
+	for (int counter = 0; counter < COUNTERS_AMOUNT; counter++) {
+		Instrumentation::_totals.counters[counter] += totals.counters[counter];
+	}
+	totals = InstrumentationTotals{};
+}
+
+void Instrumentation::addStageTime(InstrumentedStage stage, unsigned long long ns) {
+	InstrumentationTotals& totals = Instrumentation::threadTotals();
+	totals.stageNs[stage] += ns;
+	totals.stageCalls[stage]++;
+}
+
+void Instrumentation::addCount(InstrumentedCounter counter, unsigned long long amount) {
+	Instrumentation::threadTotals().counters[counter] += amount;
+}
+
+/*
+Get time of all stages finished by the calling thread since its totals were last merged.
+*/
+unsigned long long Instrumentation::threadStagesTime() {
+	InstrumentationTotals& totals = Instrumentation::threadTotals();
+	unsigned long long ns = 0;
+	for (int stage = 0; stage < STAGES_AMOUNT; stage++) {
+		ns += totals.stageNs[stage];
+	}
+
+	return ns;
+}
+
+/*
+Count size of written file as written bytes. Missing file counts as 0 bytes.
+*/
+void Instrumentation::addFileSize(std::string path) {
+	std::error_code error;
+	std::uintmax_t fileSize = std::filesystem::file_size(path, error);
+	if (!error) {
+		Instrumentation::addCount(COUNTER_BYTES_WRITTEN, fileSize);
+	}
+}
+
+/**
+Get totals of all finished threads and of the calling thread. Threads still running are not included.
+@return Summed times of stages and counters.
+*/
+InstrumentationTotals Instrumentation::collect() {
+	Instrumentation::merge(Instrumentation::threadTotals());
+	std::lock_guard<std::mutex> lock(Instrumentation::_mutex);
+	return Instrumentation::_totals;
+}
+
+/**
+Clear totals, e.g. between runs measured separately.
+*/
+void Instrumentation::reset() {
+	Instrumentation::threadTotals() = InstrumentationTotals{};
+	std::lock_guard<std::mutex> lock(Instrumentation::_mutex);
+	Instrumentation::_totals = InstrumentationTotals{};
+}
+
+std::string Instrumentation::stringifyStage(InstrumentedStage stage) {
+	switch (stage) {
+		case STAGE_LOAD_IMAGE:
+			return "loadImage";
+		case STAGE_REDUCE_GRAY_LEVELS:
+			return "reduceGrayLevels";
+		case STAGE_GLCM_ACCUMULATION:
+			return "glcmAccumulation";
+		case STAGE_FEATURE_EVALUATION:
+			return "featureEvaluation";
+		case STAGE_SAVE_IMAGE:
+			return "saveImage";
+		default:
+			return "unknown";
+	}
+}
+
+/**
+Create summary of collected totals as one JSON object.
+@return Summary with thread seconds and calls of every stage, processed windows and pairs and written bytes.
+*/
+std::string Instrumentation::report() {
+	InstrumentationTotals totals = Instrumentation::collect();
+
+	std::ostringstream summary;
+	summary << "{\"stages\": {";
+	for (int stage = 0; stage < STAGES_AMOUNT; stage++) {
+		summary << (stage > 0 ? ", " : "") << "\"" << Instrumentation::stringifyStage(static_cast<InstrumentedStage>(stage))
+			<< "\": {\"threadSeconds\": " << totals.stageNs[stage] / 1e9 << ", \"calls\": " << totals.stageCalls[stage] << "}";
+	}
+	summary << "}, \"windows\": " << totals.counters[COUNTER_WINDOWS] << ", \"pairs\": " << totals.counters[COUNTER_PAIRS]
+		<< ", \"bytesWritten\": " << totals.counters[COUNTER_BYTES_WRITTEN] << "}" << std::endl;
+
+	return summary.str();
+}
+
+StageTimer::StageTimer(InstrumentedStage stage) {
+	this->_stage = stage;
+	this->_nestedStart = Instrumentation::threadStagesTime();
+	this->_start = std::chrono::steady_clock::now();
+}
+
+StageTimer::~StageTimer() {
+	auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - this->_start);
+	unsigned long long ns = static_cast<unsigned long long>(duration.count());
+	// totals merged meanwhile (e.g. by report) drop below the start, nothing nested is known then
+	unsigned long long nestedEnd = Instrumentation::threadStagesTime();
+	unsigned long long nestedNs = nestedEnd > this->_nestedStart ? nestedEnd - this->_nestedStart : 0;
+	Instrumentation::addStageTime(this->_stage, ns - std::min(ns, nestedNs));
+}
@@ -0,0 +1,232 @@
+#include "../headers/integralGLCM.h"
+
+/**
+Build integral co-occurrence histograms of the whole image.
+@param image - successfully loaded image from disk.
+@param offsets - vector of pairs representing offsets. Any non-zero (dx, dy).
+@param storage - FULL_MATRIX gives GLCM, SUM_DIFF_HISTOGRAMS gives sum and difference histograms with much less memory.
+@param horizontal - horizontal GLCM means transformation of calculated GLCM into symmetric matrix.
+*/
+IntegralGLCM::IntegralGLCM(std::shared_ptr<Image> image, const std::vector<std::pair<int, int>>& offsets, GLCMStorage storage, bool horizontal)
+	: IntegralGLCM(image, offsets, 0, image->getImageInfo().height, storage, horizontal) {
+}
+
+/**
+Build integral co-occurrence histograms of a strip of the image. Only regions inside the strip can be calculated.
+@param image - successfully loaded image from disk.
+@param offsets - vector of pairs representing offsets. Any non-zero (dx, dy).
+@param firstRow - first row of the strip.
+@param lastRow - row after the last one of the strip.
+@param storage - FULL_MATRIX gives GLCM, SUM_DIFF_HISTOGRAMS gives sum and difference histograms with much less memory.
+@param horizontal - horizontal GLCM means transformation of calculated GLCM into symmetric matrix.
+*/
+IntegralGLCM::IntegralGLCM(std::shared_ptr<Image> image, const std::vector<std::pair<int, int>>& offsets, int firstRow, int lastRow, GLCMStorage storage, bool horizontal) {
+	if (offsets.empty()) {
+		throw new NoOffsets();
+	}
+
+	for (auto offset : offsets) {
+		if (!GLCM::checkOffset(offset)) {
+			throw new BadOffset();
+		}
+	}
+
+	this->_image = image;
+	this->_offsets = offsets;
+	this->_storage = storage;
+	this->_horizontal = horizontal;
+	this->_size = this->_image->getImageInfo().grayLevelsAmount;
+	this->_codesAmount = this->_storage == SUM_DIFF_HISTOGRAMS ? 2 * (2 * this->_size - 1) : this->_size * this->_size;
+	this->_firstRow = std::max(0, firstRow);
+	this->_lastRow = std::min(static_cast<int>(this->_image->getImageInfo().height), lastRow);
+	this->_width = this->_image->getImageInfo().width;
+	this->_glcm = std::vector<unsigned long long>(this->_codesAmount);
+	this->_pairsAmount = 0;
+	this->_weightsHeight = -1;
+	this->_weightsWidth = -1;
+	this->_weightedPairsAmount = 0;
+
+	this->buildIntegral();
+}
+
+/**
+Calculate memory needed by integral histograms of one row of the image.
+@return Amount of bytes.
+*/
+unsigned long long IntegralGLCM::calcRowMemorySize(unsigned int width, unsigned int grayLevelsAmount, unsigned int offsetsAmount, GLCMStorage storage) {
+	unsigned long long codesAmount = storage == SUM_DIFF_HISTOGRAMS ? 2 * (2 * grayLevelsAmount - 1) : grayLevelsAmount * grayLevelsAmount;
+	return (width + 1ULL) * offsetsAmount * codesAmount * sizeof(uint32_t);
+}
+
+unsigned int IntegralGLCM::pairCode(int current, int neighbour) {
+	return current * this->_size + neighbour;
+}
+
+const uint32_t* IntegralGLCM::integralAt(int offsetIndex, int row, int col) {
+	size_t position = (static_cast<size_t>(row) * (this->_width + 1) + col) * this->_offsets.size() + offsetIndex;
+	return this->_integral.data() + position * this->_codesAmount;
+}
+
+/*
+Point (row, col) of integral keeps counts of pairs with first pixel in rows <firstRow, firstRow + row) and
+columns <0, col), whose neighbour is inside the strip. Every point is the point above plus counts of its row so far.
+*/
+void IntegralGLCM::buildIntegral() {
+	GLCM_TIME_STAGE(STAGE_GLCM_ACCUMULATION);
+	cv::Mat levelIndices = this->_image->getLevelIndexImage();
+	int rowsAmount = std::max(0, this->_lastRow - this->_firstRow);
+	size_t pointSize = this->_offsets.size() * this->_codesAmount;
+	this->_integral.assign((static_cast<size_t>(rowsAmount) + 1) * (static_cast<size_t>(this->_width) + 1) * pointSize, 0);
+
+	// centered, so it can be indexed with negative differences
+	unsigned int differenceCenter = (2 * this->_size - 1) + (this->_size - 1);
+	std::vector<uint32_t> rowCounts(pointSize);
+	for (int r = 0; r < rowsAmount; r++) {
+		int row = this->_firstRow + r;
+		const uchar* currentRow = levelIndices.ptr<uchar>(row);
+		std::fill(rowCounts.begin(), rowCounts.end(), 0);
+		for (auto offset : this->_offsets) {
+			if (row + offset.second >= this->_firstRow && row + offset.second < this->_lastRow) {
+				GLCM_COUNT(COUNTER_PAIRS, std::max(0, this->_width - std::abs(offset.first)));
+			}
+		}
+
+		for (int col = 0; col < this->_width; col++) {
+			for (int k = 0; k < this->_offsets.size(); k++) {
+				int neighbourRowIndex = row + this->_offsets[k].second;
+				int neighbourCol = col + this->_offsets[k].first;
+				if (neighbourRowIndex < this->_firstRow || neighbourRowIndex >= this->_lastRow || neighbourCol < 0 || neighbourCol >= this->_width) {
+					continue;
+				}
+
+				int current = currentRow[col];
+				int neighbour = levelIndices.ptr<uchar>(neighbourRowIndex)[neighbourCol];
+				uint32_t* offsetCounts = rowCounts.data() + k * this->_codesAmount;
+				if (this->_storage == SUM_DIFF_HISTOGRAMS) {
+					offsetCounts[current + neighbour]++;
+					offsetCounts[differenceCenter + current - neighbour]++;
+				}
+				else {
+					offsetCounts[this->pairCode(current, neighbour)]++;
+				}
+			}
+
+			const uint32_t* above = this->integralAt(0, r, col + 1);
+			uint32_t* point = const_cast<uint32_t*>(this->integralAt(0, r + 1, col + 1));
+			for (size_t n = 0; n < pointSize; n++) {
+				point[n] = above[n] + rowCounts[n];
+			}
+		}
+	}
+}
+
+/**
+Calculate GLCM of square window.
+@param top - row index of left top element of window
+@param left - column index of left top element of window
+@param windowSize - window size defining scope of image to calculate.
+*/
+void IntegralGLCM::calculateGLCM(int top, int left, int windowSize) {
+	this->calculateGLCM(top, left, windowSize, windowSize);
+}
+
+/**
+Calculate GLCM (mean GLCM for more offsets) of any rectangle inside the strip with four lookups per code.
+@param top - row index of left top element of rectangle
+@param left - column index of left top element of rectangle
+@param height - height of rectangle.
+@param width - width of rectangle.
+*/
+void IntegralGLCM::calculateGLCM(int top, int left, int height, int width) {
+	GLCM_TIME_STAGE(STAGE_GLCM_ACCUMULATION);
+	if (top < this->_firstRow || top + height > this->_lastRow || left < 0 || left + width > this->_width || height <= 0 || width <= 0) {
+		throw new BadRegion();
+	}
+
+	if (height != this->_weightsHeight || width != this->_weightsWidth) {
+		this->_weightedPairsAmount = GLCM::calcOffsetWeights(this->_offsets, height, width, this->_horizontal, this->_offsetWeights);
+		this->_weightsHeight = height;
+		this->_weightsWidth = width;
+	}
+
+	std::fill(this->_glcm.begin(), this->_glcm.end(), 0);
+	unsigned long long* glcm = this->_glcm.data();
+	for (int k = 0; k < this->_offsets.size(); k++) {
+		unsigned long long weight = this->_offsetWeights[k];
+		auto [firstRow, lastRow, firstCol, lastCol] = GLCM::getPairsRange(this->_offsets[k], top - this->_firstRow, left, height, width);
+		if (weight == 0 || firstRow >= lastRow || firstCol >= lastCol) {
+			continue;
+		}
+
+		const uint32_t* bottomRight = this->integralAt(k, lastRow, lastCol);
+		const uint32_t* topRight = this->integralAt(k, firstRow, lastCol);
+		const uint32_t* bottomLeft = this->integralAt(k, lastRow, firstCol);
+		const uint32_t* topLeft = this->integralAt(k, firstRow, firstCol);
+		for (unsigned int n = 0; n < this->_codesAmount; n++) {
+			// unsigned wrap-around cancels out, result is exact count of the rectangle
+			uint32_t count = bottomRight[n] - topRight[n] - bottomLeft[n] + topLeft[n];
+			glcm[n] += weight * count;
+		}
+	}
+
+	if (this->_horizontal) {
+		this->addSymmetricCounts();
+	}
+	this->_pairsAmount = this->_weightedPairsAmount;
+}
+
+/*
+Count every pair also in reverse direction, as GLCM does for horizontal GLCM.
+*/
+void IntegralGLCM::addSymmetricCounts() {
+	unsigned long long* glcm = this->_glcm.data();
+	if (this->_storage == SUM_DIFF_HISTOGRAMS) {
+		unsigned int binsAmount = 2 * this->_size - 1;
+		for (unsigned int n = 0; n < binsAmount; n++) {
+			glcm[n] *= 2;
+		}
+
+		unsigned long long* differenceHistogram = glcm + binsAmount;
+		for (unsigned int n = 0; n < this->_size - 1; n++) {
+			unsigned long long symmetricCount = differenceHistogram[n] + differenceHistogram[binsAmount - 1 - n];
+			differenceHistogram[n] = symmetricCount;
+			differenceHistogram[binsAmount - 1 - n] = symmetricCount;
+		}
+		differenceHistogram[this->_size - 1] *= 2;
+		return;
+	}
+
+	for (unsigned int i = 0; i < this->_size; i++) {
+		glcm[i * this->_size + i] *= 2;
+		for (unsigned int j = i + 1; j < this->_size; j++) {
+			unsigned long long symmetricCount = glcm[i * this->_size + j] + glcm[j * this->_size + i];
+			glcm[i * this->_size + j] = symmetricCount;
+			glcm[j * this->_size + i] = symmetricCount;
+		}
+	}
+}
+
+/**
+Get view of calculated GLCM. View is valid until next calculation or destruction. Only for FULL_MATRIX storage.
+@return Contiguous size x size matrix of counts and their sum.
+*/
+GLCMView IntegralGLCM::getGLCM() {
+	return GLCMView{ this->_glcm.data(), this->_size, this->_pairsAmount };
+}
+
+/**
+Get view of calculated sum and difference histograms. View is valid until next calculation or destruction. Only for SUM_DIFF_HISTOGRAMS storage.
+@return Histograms with 2 * size - 1 bins and sum of counts of each of them.
+*/
+SumDiffView IntegralGLCM::getSumDiffHistograms() {
+	unsigned int binsAmount = 2 * this->_size - 1;
+	return SumDiffView{ this->_glcm.data(), this->_glcm.data() + binsAmount, this->_size, this->_pairsAmount };
+}
+
+int IntegralGLCM::getFirstRow() {
+	return this->_firstRow;
+}
+
+int IntegralGLCM::getLastRow() {
+	return this->_lastRow;
+}
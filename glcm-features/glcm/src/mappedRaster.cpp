@@ -0,0 +1,200 @@
+#include "../headers/mappedRaster.h"
+#include "../exceptions/ImageNotFoundException.h"
+
+/**
+Map binary PGM file. Sizes and bit depth are read from its header, 16-bit PGM pixels are stored big endian.
+@param path - path to stored PGM file.
+*/
+MappedRaster::MappedRaster(std::string path) {
+	this->_path = path;
+	this->mapFile();
+	if (!this->parsePgmHeader()) {
+		this->unmapFile();
+		throw new BadRasterFile(this->_path);
+	}
+	this->checkDataSize();
+}
+
+/**
+Map headerless raw file with pixels stored row by row in native byte order.
+@param path - path to stored raw file.
+@param width - width of the raster.
+@param height - height of the raster.
+@param bitDepth - 8 or 16 bits per pixel.
+@param dataOffset - amount of bytes to skip at the beginning of the file.
+*/
+MappedRaster::MappedRaster(std::string path, unsigned int width, unsigned int height, unsigned int bitDepth, unsigned long long dataOffset) {
+	this->_path = path;
+	this->_width = width;
+	this->_height = height;
+	this->_bitDepth = bitDepth;
+	this->_maxValue = (1u << bitDepth) - 1;
+	this->_dataOffset = dataOffset;
+	this->_bigEndian = false;
+	if (width == 0 || height == 0 || (bitDepth != 8 && bitDepth != 16)) {
+		throw new BadRasterFile(this->_path);
+	}
+
+	this->mapFile();
+	this->checkDataSize();
+}
+
+MappedRaster::~MappedRaster() {
+	this->unmapFile();
+}
+
+void MappedRaster::mapFile() {
+	this->_mapping = nullptr;
+	this->_mappingSize = 0;
+#ifdef _WIN32
+	this->_mappingHandle = nullptr;
+	this->_fileHandle = CreateFileA(this->_path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	LARGE_INTEGER fileSize;
+	if (this->_fileHandle == INVALID_HANDLE_VALUE || !GetFileSizeEx(this->_fileHandle, &fileSize)) {
+		this->unmapFile();
+		throw new ImageNotFoundException(this->_path);
+	}
+	this->_mappingSize = static_cast<unsigned long long>(fileSize.QuadPart);
+	this->_mappingHandle = CreateFileMappingA(this->_fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (this->_mappingHandle != nullptr) {
+		this->_mapping = static_cast<const uchar*>(MapViewOfFile(this->_mappingHandle, FILE_MAP_READ, 0, 0, 0));
+	}
+#else
+	this->_fileDescriptor = open(this->_path.c_str(), O_RDONLY);
+	struct stat fileStatus;
+	if (this->_fileDescriptor < 0 || fstat(this->_fileDescriptor, &fileStatus) != 0) {
+		this->unmapFile();
+		throw new ImageNotFoundException(this->_path);
+	}
+	this->_mappingSize = static_cast<unsigned long long>(fileStatus.st_size);
+	if (this->_mappingSize > 0) {
+		void* mapping = mmap(nullptr, this->_mappingSize, PROT_READ, MAP_PRIVATE, this->_fileDescriptor, 0);
+		this->_mapping = mapping == MAP_FAILED ? nullptr : static_cast<const uchar*>(mapping);
+	}
+#endif
+
+	if (this->_mapping == nullptr) {
+		this->unmapFile();
+		throw new ImageNotFoundException(this->_path);
+	}
+}
+
+void MappedRaster::unmapFile() {
+#ifdef _WIN32
+	if (this->_mapping != nullptr) {
+		UnmapViewOfFile(this->_mapping);
+	}
+	if (this->_mappingHandle != nullptr) {
+		CloseHandle(this->_mappingHandle);
+	}
+	if (this->_fileHandle != INVALID_HANDLE_VALUE) {
+		CloseHandle(this->_fileHandle);
+	}
+	this->_mappingHandle = nullptr;
+	this->_fileHandle = INVALID_HANDLE_VALUE;
+#else
+	if (this->_mapping != nullptr) {
+		munmap(const_cast<uchar*>(this->_mapping), this->_mappingSize);
+	}
+	if (this->_fileDescriptor >= 0) {
+		close(this->_fileDescriptor);
+	}
+	this->_fileDescriptor = -1;
+#endif
+	this->_mapping = nullptr;
+}
+
+/*
+Parse header of binary PGM. Header is followed by exactly one whitespace character and pixels.
+*/
+bool MappedRaster::parsePgmHeader() {
+	if (this->_mappingSize < 2 || this->_mapping[0] != 'P' || this->_mapping[1] != '5') {
+		return false;
+	}
+
+	unsigned long long position = 2;
+	if (!this->parsePgmNumber(position, this->_width) || !this->parsePgmNumber(position, this->_height) ||
+		!this->parsePgmNumber(position, this->_maxValue)) {
+		return false;
+	}
+	if (this->_width == 0 || this->_height == 0 || this->_maxValue == 0 || this->_maxValue > 65535) {
+		return false;
+	}
+
+	this->_bitDepth = this->_maxValue > 255 ? 16 : 8;
+	this->_bigEndian = this->_bitDepth == 16;
+	this->_dataOffset = position + 1;
+
+	return true;
+}
+
+bool MappedRaster::parsePgmNumber(unsigned long long& position, unsigned int& number) {
+	while (position < this->_mappingSize && (std::isspace(this->_mapping[position]) || this->_mapping[position] == '#')) {
+		if (this->_mapping[position] == '#') {
+			while (position < this->_mappingSize && this->_mapping[position] != '\n') {
+				position++;
+			}
+		}
+		else {
+			position++;
+		}
+	}
+
+	if (position >= this->_mappingSize || !std::isdigit(this->_mapping[position])) {
+		return false;
+	}
+
+	unsigned long long value = 0;
+	while (position < this->_mappingSize && std::isdigit(this->_mapping[position]) && value <= UINT_MAX) {
+		value = value * 10 + (this->_mapping[position] - '0');
+		position++;
+	}
+	number = static_cast<unsigned int>(std::min<unsigned long long>(value, UINT_MAX));
+
+	return value <= UINT_MAX;
+}
+
+void MappedRaster::checkDataSize() {
+	unsigned long long dataSize = static_cast<unsigned long long>(this->_width) * this->_height * (this->_bitDepth / 8);
+	if (this->_dataOffset > this->_mappingSize || this->_mappingSize - this->_dataOffset < dataSize) {
+		this->unmapFile();
+		throw new BadRasterFile(this->_path);
+	}
+}
+
+/**
+Wrap mapped pixels in matrix header. No pixels are copied or read.
+@return read-only CV_8UC1 or CV_16UC1 matrix, valid as long as the raster exists. 16-bit pixels of PGM files are big endian.
+*/
+cv::Mat MappedRaster::getPixels() {
+	int matType = this->_bitDepth == 16 ? CV_16UC1 : CV_8UC1;
+	return cv::Mat(this->_height, this->_width, matType, const_cast<uchar*>(this->_mapping + this->_dataOffset));
+}
+
+std::string MappedRaster::getPath() {
+	return this->_path;
+}
+
+unsigned int MappedRaster::getWidth() {
+	return this->_width;
+}
+
+unsigned int MappedRaster::getHeight() {
+	return this->_height;
+}
+
+unsigned int MappedRaster::getBitDepth() {
+	return this->_bitDepth;
+}
+
+/**
+Get the biggest pixel value of the raster - max value from PGM header or 2^bitDepth - 1 for raw files.
+@return max pixel value.
+*/
+unsigned int MappedRaster::getMaxValue() {
+	return this->_maxValue;
+}
+
+bool MappedRaster::isBigEndian() {
+	return this->_bigEndian;
+}
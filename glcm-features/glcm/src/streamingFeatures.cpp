@@ -0,0 +1,173 @@
+#include "../headers/streamingFeatures.h"
+
+/**
+Open image for strip by strip processing. Only amount of gray levels is calculated up front, in one streamed pass.
+@param path - path to stored image. Binary 8-bit PGM files are streamed from disk, other formats are loaded whole.
+@param grayLevelsAmount - target amount of gray levels.
+@param windowSize - size of square window used for GLCM calculations. Should be odd positive number that fits image sizes.
+@param memoryBudget - approximate limit in bytes of memory used by strips of input and feature images.
+*/
+StreamingGLCMFeatures::StreamingGLCMFeatures(std::string path, int grayLevelsAmount, unsigned int windowSize, unsigned long long memoryBudget) {
+	this->_reader = std::make_unique<StripReader>(path);
+	this->_grayLevelsAmount = grayLevelsAmount;
+	this->_originalGrayLevelsAmount = this->_reader->countGrayLevels();
+	this->validWindowSize(windowSize);
+	this->_memoryBudget = memoryBudget;
+	this->_computationMode = SLIDING_WINDOW;
+	this->_threadsAmount = DEFAULT_THREADS_AMOUNT;
+	this->_storage = FULL_MATRIX;
+	this->_simdLevel = detectSimdLevel();
+	this->_outputFormat = FLOAT_NPY;
+}
+
+void StreamingGLCMFeatures::validWindowSize(unsigned int windowSize) {
+	if (windowSize % 2 == 1 && windowSize <= this->_reader->getWidth() && windowSize <= this->_reader->getHeight()) {
+		this->_windowSize = windowSize;
+	}
+	else {
+		std::cerr << "Wrong window size. It has to be positive odd number that fits image sizes.\n";
+		this->_windowSize = DEFAULT_WINDOW_SIZE;
+	}
+}
+
+/*
+Set approximate limit of memory used by strips. Strips never get less than windowSize rows, so very small budgets
+are exceeded.
+@param memoryBudget - limit in bytes.
+*/
+void StreamingGLCMFeatures::setMemoryBudget(unsigned long long memoryBudget) {
+	this->_memoryBudget = memoryBudget;
+}
+
+void StreamingGLCMFeatures::setComputationMode(ComputationMode computationMode) {
+	this->_computationMode = computationMode;
+}
+
+void StreamingGLCMFeatures::setThreadsAmount(unsigned int threadsAmount) {
+	this->_threadsAmount = threadsAmount;
+}
+
+void StreamingGLCMFeatures::setSimdLevel(SimdLevel simdLevel) {
+	this->_simdLevel = simdLevel;
+}
+
+void StreamingGLCMFeatures::setGLCMStorage(GLCMStorage storage) {
+	this->_storage = storage;
+}
+
+/*
+Select format of written feature images. Float TIFF can't be written in strips, so FLOAT_TIFF gives .npy files as FLOAT_NPY.
+Stacked formats also give one .npy file per feature, bands of a stack would have to be kept until the last strip.
+QUANTIZED_GRAY_LEVELS gives 8-bit PGM files.
+@param outputFormat - format of written feature images.
+*/
+void StreamingGLCMFeatures::setOutputFormat(FeatureImageFormat outputFormat) {
+	this->_outputFormat = outputFormat;
+}
+
+/**
+Calculate and write images of all given features from GLCM with given offset.
+@param offset - pair representing offset. Any non-zero (dx, dy).
+@param featureTypes - set of features to calculate.
+*/
+void StreamingGLCMFeatures::features(std::pair<int, int> offset, std::set<FeatureType> featureTypes) {
+	this->calcFeatureStrips(std::vector<std::pair<int, int>>{ offset }, featureTypes, false);
+}
+
+/**
+Calculate and write images of all given features from mean GLCM with given vector of offsets.
+@param offsets - vector of pairs representing offsets. Any non-zero (dx, dy).
+@param featureTypes - set of features to calculate.
+*/
+void StreamingGLCMFeatures::features(std::vector<std::pair<int, int>> offsets, std::set<FeatureType> featureTypes) {
+	this->calcFeatureStrips(offsets, featureTypes, true);
+}
+
+/*
+Amount of output rows per strip that fits memory budget. Every row of a strip keeps input pixels, gray level indices,
+one 16-bit pair code per offset and one float value per feature.
+*/
+int StreamingGLCMFeatures::calcStripRowsAmount(int featuresAmount, int offsetsAmount) {
+	unsigned long long rowBytes = static_cast<unsigned long long>(this->_reader->getWidth()) * (2 + sizeof(ushort) * offsetsAmount + sizeof(float) * featuresAmount);
+	long long rowsAmount = static_cast<long long>(this->_memoryBudget / rowBytes) - this->_windowSize;
+
+	return static_cast<int>(std::clamp<long long>(rowsAmount, this->_windowSize, this->_reader->getHeight()));
+}
+
+/*
+Create GLCM_features for image rows <firstRow, lastRow) with the same settings as whole image.
+*/
+std::unique_ptr<GLCM_features> StreamingGLCMFeatures::createStripFeatures(int firstRow, int lastRow) {
+	cv::Mat pixels = this->_reader->readRows(firstRow, lastRow);
+	std::shared_ptr<Image> strip = std::make_shared<Image>(this->_reader->getPath(), pixels, this->_grayLevelsAmount, this->_originalGrayLevelsAmount);
+
+	std::unique_ptr<GLCM_features> stripFeatures = std::make_unique<GLCM_features>(strip, this->_windowSize, this->_computationMode);
+	stripFeatures->setThreadsAmount(this->_threadsAmount);
+	stripFeatures->setSimdLevel(this->_simdLevel);
+	stripFeatures->setGLCMStorage(this->_storage);
+
+	return stripFeatures;
+}
+
+std::vector<std::unique_ptr<Image>> StreamingGLCMFeatures::calcStripFeatureMaps(std::unique_ptr<GLCM_features>& stripFeatures, std::vector<std::pair<int, int>>& offsets, std::set<FeatureType>& featureTypes, bool meanGLCM) {
+	if (meanGLCM) {
+		return stripFeatures->featureMaps(offsets, featureTypes);
+	}
+
+	return stripFeatures->featureMaps(offsets[0], featureTypes);
+}
+
+/*
+Feature of output row y is calculated from window with top row y - windowSize / 2. Strip with output rows <firstRow, lastRow)
+needs input rows <firstRow - windowSize / 2, lastRow - windowSize / 2 + windowSize), clipped to the image. Window positions
+of such strip are exactly the ones of whole image that give its output rows, so results do not depend on strip size.
+*/
+void StreamingGLCMFeatures::calcFeatureStrips(std::vector<std::pair<int, int>> offsets, std::set<FeatureType> featureTypes, bool meanGLCM) {
+	int height = this->_reader->getHeight();
+	int halfWindow = this->_windowSize / 2;
+	int stripRowsAmount = this->calcStripRowsAmount(static_cast<int>(featureTypes.size()), static_cast<int>(offsets.size()));
+
+	std::vector<std::unique_ptr<StripWriter>> writers;
+	for (int firstRow = 0; firstRow < height; firstRow += stripRowsAmount) {
+		int lastRow = std::min(height, firstRow + stripRowsAmount);
+		int firstInputRow = std::max(0, firstRow - halfWindow);
+		int lastInputRow = std::min(height, lastRow - halfWindow + static_cast<int>(this->_windowSize));
+
+		// bottom border of the image, no window gives these rows
+		if (lastInputRow - firstInputRow < static_cast<int>(this->_windowSize)) {
+			for (auto& writer : writers) {
+				writer->writeZeroRows(lastRow - firstRow);
+			}
+			continue;
+		}
+
+		std::unique_ptr<GLCM_features> stripFeatures = this->createStripFeatures(firstInputRow, lastInputRow);
+		std::vector<std::unique_ptr<Image>> featureMaps = this->calcStripFeatureMaps(stripFeatures, offsets, featureTypes, meanGLCM);
+		for (int k = 0; k < featureMaps.size(); k++) {
+			if (writers.size() == k) {
+				writers.push_back(this->createWriter(featureMaps[k]));
+			}
+			if (this->_outputFormat == QUANTIZED_GRAY_LEVELS) {
+				featureMaps[k]->quantizeToGrayLevels();
+			}
+			writers[k]->writeRows(featureMaps[k]->getImage(), firstRow - firstInputRow, lastRow - firstInputRow);
+		}
+	}
+
+	for (auto& writer : writers) {
+		if (!writer->isGood() || !writer->isComplete()) {
+			std::cerr << "Writing streamed feature image FAILED!" << std::endl;
+		}
+	}
+}
+
+/*
+Open output file named as feature image calculated from the whole image would be.
+*/
+std::unique_ptr<StripWriter> StreamingGLCMFeatures::createWriter(std::unique_ptr<Image>& featureMap) {
+	bool quantized = this->_outputFormat == QUANTIZED_GRAY_LEVELS;
+	std::string path = std::filesystem::path(featureMap->getPath()).replace_extension(quantized ? ".pgm" : ".npy").string();
+	std::cout << "Streaming " + std::filesystem::path(path).filename().string() << std::endl;
+
+	return std::make_unique<StripWriter>(path, this->_reader->getHeight(), this->_reader->getWidth(), quantized ? CV_8UC1 : CV_32FC1);
+}
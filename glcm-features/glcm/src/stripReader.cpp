@@ -0,0 +1,148 @@
+#include "../headers/stripReader.h"
+#include "../exceptions/ImageNotFoundException.h"
+
+/**
+Open image for reading in strips.
+@param path - path to stored image.
+*/
+StripReader::StripReader(std::string path) {
+	this->_path = path;
+	this->_dataOffset = 0;
+	this->_width = 0;
+	this->_height = 0;
+	this->_file.open(this->_path, std::ios::binary);
+	this->_streamed = this->_file && this->readPgmHeader();
+	if (this->_streamed) {
+		return;
+	}
+
+	this->_file.close();
+	GLCM_TIME_STAGE(STAGE_LOAD_IMAGE);
+	this->_wholeImage = cv::imread(this->_path, cv::IMREAD_GRAYSCALE);
+	if (this->_wholeImage.empty()) {
+		std::cerr << "Error: Unable to load the image." << std::endl;
+		throw new ImageNotFoundException(this->_path);
+	}
+	this->_width = this->_wholeImage.cols;
+	this->_height = this->_wholeImage.rows;
+}
+
+/*
+Parse header of binary PGM ("P5") file. Only 8-bit images (max value below 256) can be streamed.
+*/
+bool StripReader::readPgmHeader() {
+	char magic[2];
+	if (!this->_file.read(magic, 2) || magic[0] != 'P' || magic[1] != '5') {
+		return false;
+	}
+
+	int maxValue = 0;
+	if (!this->readPgmNumber(this->_width) || !this->readPgmNumber(this->_height) || !this->readPgmNumber(maxValue)) {
+		return false;
+	}
+	if (this->_width <= 0 || this->_height <= 0 || maxValue <= 0 || maxValue > 255) {
+		return false;
+	}
+
+	// exactly one whitespace character separates header from pixels
+	this->_file.get();
+	this->_dataOffset = this->_file.tellg();
+
+	return static_cast<bool>(this->_file);
+}
+
+bool StripReader::readPgmNumber(int& number) {
+	int character = this->_file.get();
+	while (character != EOF && (std::isspace(character) || character == '#')) {
+		if (character == '#') {
+			while (character != EOF && character != '\n') {
+				character = this->_file.get();
+			}
+		}
+		character = this->_file.get();
+	}
+
+	if (!std::isdigit(character)) {
+		return false;
+	}
+
+	number = 0;
+	while (std::isdigit(character)) {
+		number = number * 10 + (character - '0');
+		character = this->_file.get();
+	}
+	this->_file.unget();
+
+	return true;
+}
+
+/**
+Read rows of the image.
+@param firstRow - first row of the strip.
+@param lastRow - row after the last one of the strip.
+@return 8-bit matrix with rows <firstRow, lastRow) of the image.
+*/
+cv::Mat StripReader::readRows(int firstRow, int lastRow) {
+	GLCM_TIME_STAGE(STAGE_LOAD_IMAGE);
+	if (!this->_streamed) {
+		return this->_wholeImage.rowRange(firstRow, lastRow).clone();
+	}
+
+	cv::Mat strip(lastRow - firstRow, this->_width, CV_8UC1);
+	this->_file.clear();
+	this->_file.seekg(this->_dataOffset + static_cast<std::streamoff>(firstRow) * this->_width);
+	for (int i = 0; i < strip.rows; i++) {
+		this->_file.read(reinterpret_cast<char*>(strip.ptr<uchar>(i)), this->_width);
+	}
+	if (!this->_file) {
+		std::cerr << "Error: Unable to read rows of the image." << std::endl;
+		throw new ImageNotFoundException(this->_path);
+	}
+
+	return strip;
+}
+
+/**
+Count distinct pixel values of the whole image. Reads image in strips, so memory usage does not depend on image size.
+@return amount of gray levels of the image.
+*/
+unsigned int StripReader::countGrayLevels() {
+	bool usedLevels[256] = {};
+	int stripRows = std::max(1, (1 << 20) / this->_width);
+	for (int firstRow = 0; firstRow < this->_height; firstRow += stripRows) {
+		cv::Mat strip = this->readRows(firstRow, std::min(this->_height, firstRow + stripRows));
+		for (int i = 0; i < strip.rows; i++) {
+			const uchar* pixelRow = strip.ptr<uchar>(i);
+			for (int j = 0; j < strip.cols; j++) {
+				usedLevels[pixelRow[j]] = true;
+			}
+		}
+	}
+
+	unsigned int grayLevelsAmount = 0;
+	for (bool used : usedLevels) {
+		grayLevelsAmount += used ? 1 : 0;
+	}
+
+	return grayLevelsAmount;
+}
+
+int StripReader::getWidth() {
+	return this->_width;
+}
+
+int StripReader::getHeight() {
+	return this->_height;
+}
+
+std::string StripReader::getPath() {
+	return this->_path;
+}
+
+/**
+Check if image is read from disk strip by strip or was loaded whole.
+@return true for streamed binary PGM files.
+*/
+bool StripReader::isStreamed() {
+	return this->_streamed;
+}
@@ -0,0 +1,96 @@
+#include "../headers/stripWriter.h"
+
+/**
+Open output file and write its header. Size of the image has to be known up front.
+@param path - path of created file.
+@param rows - height of the whole image.
+@param cols - width of the whole image.
+@param matType - CV_32FC1 for .npy output or CV_8UC1 for PGM output.
+@param bandsAmount - amount of bands written one after another, only for .npy output. Rows of all bands are counted
+		as rows of one image, the first band is written first.
+*/
+StripWriter::StripWriter(std::string path, int rows, int cols, int matType, int bandsAmount) {
+	this->_rows = rows;
+	this->_cols = cols;
+	this->_matType = matType;
+	this->_bandsAmount = this->_matType == CV_32FC1 ? std::max(1, bandsAmount) : 1;
+	this->_writtenRows = 0;
+	this->_file.open(path, std::ios::binary);
+	if (!this->_file) {
+		return;
+	}
+
+	if (this->_matType == CV_32FC1) {
+		this->writeNpyHeader();
+	}
+	else {
+		this->writePgmHeader();
+	}
+}
+
+/*
+NumPy format version 1.0, little endian float32 in C order. Header is padded to 64 bytes.
+*/
+void StripWriter::writeNpyHeader() {
+	std::string shape = std::to_string(this->_rows) + ", " + std::to_string(this->_cols);
+	if (this->_bandsAmount > 1) {
+		shape = std::to_string(this->_bandsAmount) + ", " + shape;
+	}
+	std::string header = "{'descr': '<f4', 'fortran_order': False, 'shape': (" + shape + "), }";
+	// magic string, version and header length take 10 bytes
+	size_t paddedLength = (10 + header.size() + 1 + 63) / 64 * 64;
+	header.append(paddedLength - 10 - header.size() - 1, ' ');
+	header.push_back('\n');
+	GLCM_COUNT(COUNTER_BYTES_WRITTEN, 10 + header.size());
+
+	unsigned short headerLength = static_cast<unsigned short>(header.size());
+	this->_file.write("\x93NUMPY\x01\x00", 8);
+	this->_file.put(static_cast<char>(headerLength & 0xFF));
+	this->_file.put(static_cast<char>(headerLength >> 8));
+	this->_file.write(header.data(), header.size());
+}
+
+void StripWriter::writePgmHeader() {
+	std::string header = "P5\n" + std::to_string(this->_cols) + " " + std::to_string(this->_rows) + "\n255\n";
+	this->_file << header;
+	GLCM_COUNT(COUNTER_BYTES_WRITTEN, header.size());
+}
+
+/**
+Append rows of the strip to the file. Rows have to be written in order, from top of the image.
+@param strip - matrix of the same width and type as the written image.
+@param firstRow - first row of the strip to write.
+@param lastRow - row after the last one to write.
+*/
+void StripWriter::writeRows(const cv::Mat& strip, int firstRow, int lastRow) {
+	GLCM_TIME_STAGE(STAGE_SAVE_IMAGE);
+	size_t rowBytes = static_cast<size_t>(this->_cols) * strip.elemSize();
+	for (int i = firstRow; i < lastRow; i++) {
+		this->_file.write(reinterpret_cast<const char*>(strip.ptr<uchar>(i)), rowBytes);
+	}
+	GLCM_COUNT(COUNTER_BYTES_WRITTEN, rowBytes * (lastRow - firstRow));
+	this->_writtenRows += lastRow - firstRow;
+}
+
+/**
+Append rows filled with zeros, e.g. image border where no window fits.
+@param rowsAmount - amount of rows to write.
+*/
+void StripWriter::writeZeroRows(int rowsAmount) {
+	cv::Mat zeros = cv::Mat::zeros(1, this->_cols, this->_matType);
+	for (int i = 0; i < rowsAmount; i++) {
+		this->writeRows(zeros, 0, 1);
+	}
+}
+
+/**
+Check if all rows of the image were written.
+@return true if file contains whole image with all its bands.
+*/
+bool StripWriter::isComplete() {
+	return this->_writtenRows == this->_rows * this->_bandsAmount;
+}
+
+bool StripWriter::isGood() {
+	return static_cast<bool>(this->_file);
+}
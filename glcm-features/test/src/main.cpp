@@ -0,0 +1,433 @@
+#include "../../glcm/headers/glcm_features.h"
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+
+#define TEXTURE_WIDTH 41
+#define TEXTURE_HEIGHT 33
+#define TEXTURE_SEED 2024
+#define MAX_REPORTED_MISMATCHES 5
+#define KERNEL_SEED 7
+#define KERNEL_GLCMS_AMOUNT 20
+// documented bound of difference between SIMD and scalar kernels
+#define KERNEL_RELATIVE_TOLERANCE 1e-12
+// mean GLCM of many offset lengths has rounded offset weights, features are compared with plain mean of normalized GLCMs
+#define MEAN_GLCM_RELATIVE_TOLERANCE 1e-5
+#define LONG_OFFSETS_MAX_DISTANCE 8
+// features of different kernels differ by less than 1e-12 relative in double, that is at most one float ulp
+#define KERNELS_ULPS_TOLERANCE 2
+
+/*
+Equivalence test of glcm library. Feature maps of every computation mode, GLCM storage and threads amount are compared
+with brute force on a fixed texture, pixel by pixel. Maps evaluated by the same feature kernel have to be equal, maps of
+full matrix kernels, which may be SIMD ones, and of sparse kernels may differ by KERNELS_ULPS_TOLERANCE float ulps.
+Feature tables of selected pixels are compared with the same pixels of feature maps. Mean GLCM of offsets of many
+lengths in big windows, whose offset weights can't be exact, is compared with mean of normalized GLCMs in double.
+Feature kernels of every supported SIMD level are compared with generic scalar kernel on random GLCMs.
+Returns non-zero when any value differs.
+*/
+
+struct TestCase {
+	ComputationMode computationMode;
+	GLCMStorage storage;
+	unsigned int threadsAmount;
+};
+
+/*
+Brute force feature maps of every GLCM storage with the same offsets and window sizes.
+*/
+struct ReferenceMaps {
+	std::vector<std::unique_ptr<Image>> full;
+	std::vector<std::unique_ptr<Image>> sparse;
+	std::vector<std::unique_ptr<Image>> sumDiff;
+};
+
+/*
+Linear congruential generator, so the texture is the same on every platform and standard library.
+*/
+unsigned int nextRandom(unsigned long long& state) {
+	state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+	return static_cast<unsigned int>(state >> 33);
+}
+
+/*
+Create 8-bit texture of waves with noise, so GLCMs are neither uniform nor concentrated in a few cells.
+*/
+cv::Mat createTexture() {
+	cv::Mat texture(TEXTURE_HEIGHT, TEXTURE_WIDTH, CV_8UC1);
+	unsigned long long state = TEXTURE_SEED;
+	for (int i = 0; i < TEXTURE_HEIGHT; i++) {
+		uchar* row = texture.ptr<uchar>(i);
+		for (int j = 0; j < TEXTURE_WIDTH; j++) {
+			double wave = 90.0 * std::sin(j * 0.37 + 0.5 * std::sin(i * 0.11)) + 30.0 * std::cos(i * 0.23);
+			int noise = static_cast<int>(nextRandom(state) % 64) - 32;
+			row[j] = static_cast<uchar>(std::clamp(128.0 + wave + noise, 0.0, 255.0));
+		}
+	}
+
+	return texture;
+}
+
+std::string stringifyTestCase(TestCase testCase) {
+	std::string modes[] = { "bruteForce", "sliding", "integral", "columns" };
+	std::string storages[] = { "full", "sumDiff", "sparse" };
+	return modes[testCase.computationMode] + "/" + storages[testCase.storage] + "/" + std::to_string(testCase.threadsAmount) + " threads";
+}
+
+std::vector<std::unique_ptr<Image>> calcFeatureMaps(std::shared_ptr<Image> image, std::vector<unsigned int> windowSizes, TestCase testCase, std::vector<std::pair<int, int>> offsets, bool meanGLCM, std::set<FeatureType> featureTypes) {
+	std::unique_ptr<GLCM_features> glcmFeatures = std::make_unique<GLCM_features>(image, windowSizes, testCase.computationMode);
+	glcmFeatures->setThreadsAmount(testCase.threadsAmount);
+	glcmFeatures->setGLCMStorage(testCase.storage);
+	if (meanGLCM) {
+		return glcmFeatures->featureMaps(offsets, featureTypes);
+	}
+
+	return glcmFeatures->featureMaps(offsets.front(), featureTypes);
+}
+
+ReferenceMaps calcReferenceMaps(std::shared_ptr<Image> image, std::vector<unsigned int> windowSizes, std::vector<std::pair<int, int>> offsets, bool meanGLCM, std::set<FeatureType> featureTypes) {
+	ReferenceMaps reference;
+	reference.full = calcFeatureMaps(image, windowSizes, TestCase{ BRUTE_FORCE, FULL_MATRIX, 1 }, offsets, meanGLCM, featureTypes);
+	reference.sparse = calcFeatureMaps(image, windowSizes, TestCase{ BRUTE_FORCE, SPARSE_MATRIX, 1 }, offsets, meanGLCM, featureTypes);
+	reference.sumDiff = calcFeatureMaps(image, windowSizes, TestCase{ BRUTE_FORCE, SUM_DIFF_HISTOGRAMS, 1 }, offsets, meanGLCM, featureTypes);
+
+	return reference;
+}
+
+/*
+Check if values are equal or at most ulpsTolerance floats apart. NaN is equal to NaN.
+*/
+bool areValuesEqual(float expectedValue, float actualValue, unsigned int ulpsTolerance) {
+	if (expectedValue == actualValue || (std::isnan(expectedValue) && std::isnan(actualValue))) {
+		return true;
+	}
+	if (ulpsTolerance == 0 || std::isnan(expectedValue) || std::isnan(actualValue) || std::signbit(expectedValue) != std::signbit(actualValue)) {
+		return false;
+	}
+
+	// floats of the same sign are ordered as their bits
+	int32_t expectedBits;
+	int32_t actualBits;
+	std::memcpy(&expectedBits, &expectedValue, sizeof(float));
+	std::memcpy(&actualBits, &actualValue, sizeof(float));
+	return std::abs(static_cast<long long>(expectedBits) - actualBits) <= ulpsTolerance;
+}
+
+/*
+Compare pixels of feature maps with reference maps calculated the same way.
+@param compared - indices of maps to compare, other maps are skipped.
+@param ulpsTolerance - allowed difference in float ulps, 0 when maps come from the same kernel.
+@return amount of differing pixels.
+*/
+unsigned long long compareFeatureMaps(std::vector<std::unique_ptr<Image>>& reference, std::vector<std::unique_ptr<Image>>& featureMaps, std::vector<size_t> compared, unsigned int ulpsTolerance, std::string description) {
+	if (reference.size() != featureMaps.size()) {
+		std::cerr << description << ": " << featureMaps.size() << " feature maps instead of " << reference.size() << "\n";
+		return 1;
+	}
+
+	unsigned long long mismatchesAmount = 0;
+	for (size_t n : compared) {
+		cv::Mat expected = reference[n]->getImage();
+		cv::Mat actual = featureMaps[n]->getImage();
+		for (int i = 0; i < expected.rows; i++) {
+			for (int j = 0; j < expected.cols; j++) {
+				float expectedValue = expected.at<float>(i, j);
+				float actualValue = actual.at<float>(i, j);
+				if (areValuesEqual(expectedValue, actualValue, ulpsTolerance)) {
+					continue;
+				}
+
+				if (mismatchesAmount < MAX_REPORTED_MISMATCHES) {
+					std::cerr << description << ": " << featureMaps[n]->getImageInfo().imageName << " (" << i << ", " << j << ") is "
+						<< actualValue << " instead of " << expectedValue << "\n";
+				}
+				mismatchesAmount++;
+			}
+		}
+	}
+
+	return mismatchesAmount;
+}
+
+/*
+Compare brute force feature maps of mean GLCM with features of mean of normalized GLCMs of every offset, calculated
+in double for every window calculated by feature maps. Features have to be in order ENERGY, ENTROPY, CONTRAST, HOMOGENEITY.
+@return amount of differing values.
+*/
+unsigned long long compareMeanGLCMFeatures(std::shared_ptr<Image> image, std::vector<std::unique_ptr<Image>>& featureMaps, std::vector<unsigned int> windowSizes, std::vector<std::pair<int, int>> offsets, std::string description) {
+	cv::Mat levelIndices = image->getLevelIndexImage();
+	int size = static_cast<int>(image->getImageInfo().grayLevelsAmount);
+	unsigned long long mismatchesAmount = 0;
+	for (size_t s = 0; s < windowSizes.size(); s++) {
+		int windowSize = static_cast<int>(windowSizes[s]);
+		for (int top = 0; top + windowSize < TEXTURE_HEIGHT; top++) {
+			for (int left = 0; left + windowSize < TEXTURE_WIDTH; left++) {
+				std::vector<double> meanGLCM(size * size, 0.0);
+				for (auto offset : offsets) {
+					std::vector<double> glcm(size * size, 0.0);
+					double pairsAmount = 0.0;
+					for (int i = top; i < top + windowSize; i++) {
+						for (int j = left; j < left + windowSize; j++) {
+							int neighbourRow = i + offset.second;
+							int neighbourCol = j + offset.first;
+							if (neighbourRow < top || neighbourRow >= top + windowSize || neighbourCol < left || neighbourCol >= left + windowSize) {
+								continue;
+							}
+							glcm[levelIndices.at<uchar>(i, j) * size + levelIndices.at<uchar>(neighbourRow, neighbourCol)] += 1.0;
+							pairsAmount += 1.0;
+						}
+					}
+					for (int c = 0; c < size * size; c++) {
+						meanGLCM[c] += glcm[c] / pairsAmount / offsets.size();
+					}
+				}
+
+				double expectedValues[4] = { 0.0, 0.0, 0.0, 0.0 };
+				for (int c = 0; c < size * size; c++) {
+					double p = meanGLCM[c];
+					int difference = c / size - c % size;
+					expectedValues[0] += p * p;
+					expectedValues[1] -= p > 0.0 ? p * std::log(p) : 0.0;
+					expectedValues[2] += p * difference * difference;
+					expectedValues[3] += p / (1 + difference * difference);
+				}
+
+				for (int f = 0; f < 4; f++) {
+					float actualValue = featureMaps[s * 4 + f]->getImage().at<float>(top + windowSize / 2, left + windowSize / 2);
+					if (std::abs(actualValue - expectedValues[f]) <= MEAN_GLCM_RELATIVE_TOLERANCE * std::abs(expectedValues[f])) {
+						continue;
+					}
+
+					if (mismatchesAmount < MAX_REPORTED_MISMATCHES) {
+						std::cerr << description << ": " << featureMaps[s * 4 + f]->getImageInfo().imageName << " (" << top + windowSize / 2 << ", " << left + windowSize / 2
+							<< ") is " << actualValue << " instead of " << expectedValues[f] << "\n";
+					}
+					mismatchesAmount++;
+				}
+			}
+		}
+	}
+
+	return mismatchesAmount;
+}
+
+/*
+Compare feature maps of every test case with brute force reference maps of the same offsets and window sizes.
+Sum and difference histograms and sparse GLCMs outside integral histograms are evaluated by the same kernels in every
+computation mode, so they have to equal brute force over the same storage. Full matrix may be switched to sparse one
+for different windows in different modes and integral histograms are always evaluated as full matrix, so these are
+compared with brute force over full matrix with tolerance. More threads have to give the same maps as one thread.
+Test cases of one computation mode and storage have to follow each other, starting with one thread.
+@return amount of differing values.
+*/
+unsigned long long compareTestCases(std::shared_ptr<Image> image, std::vector<TestCase>& testCases, std::vector<unsigned int> windowSizes, std::vector<std::pair<int, int>> offsets, bool meanGLCM, std::set<FeatureType> featureTypes,
+	ReferenceMaps& reference, std::string description) {
+	// indices of exact features of sum and difference histograms, in order of featureTypes
+	std::vector<size_t> allMaps;
+	std::vector<size_t> sumDiffExactMaps;
+	for (size_t s = 0; s < windowSizes.size(); s++) {
+		size_t f = 0;
+		for (auto featureType : featureTypes) {
+			allMaps.push_back(s * featureTypes.size() + f);
+			if (featureType == CONTRAST || featureType == HOMOGENEITY) {
+				sumDiffExactMaps.push_back(s * featureTypes.size() + f);
+			}
+			f++;
+		}
+	}
+
+	unsigned long long mismatchesAmount = compareFeatureMaps(reference.full, reference.sparse, allMaps, KERNELS_ULPS_TOLERANCE, "sparse reference, " + description);
+	std::vector<std::unique_ptr<Image>> singleThreadMaps;
+	for (auto testCase : testCases) {
+		std::string caseDescription = stringifyTestCase(testCase) + ", " + description;
+		std::vector<std::unique_ptr<Image>> featureMaps = calcFeatureMaps(image, windowSizes, testCase, offsets, meanGLCM, featureTypes);
+		if (testCase.threadsAmount > 1) {
+			mismatchesAmount += compareFeatureMaps(singleThreadMaps, featureMaps, allMaps, 0, caseDescription);
+			continue;
+		}
+
+		if (testCase.storage == SUM_DIFF_HISTOGRAMS) {
+			// approximated features only have to agree between computation modes
+			mismatchesAmount += compareFeatureMaps(reference.sumDiff, featureMaps, allMaps, 0, caseDescription);
+			mismatchesAmount += compareFeatureMaps(reference.full, featureMaps, sumDiffExactMaps, KERNELS_ULPS_TOLERANCE, caseDescription);
+		}
+		else if (testCase.storage == SPARSE_MATRIX && testCase.computationMode != INTEGRAL_HISTOGRAMS) {
+			mismatchesAmount += compareFeatureMaps(reference.sparse, featureMaps, allMaps, 0, caseDescription);
+		}
+		else {
+			mismatchesAmount += compareFeatureMaps(reference.full, featureMaps, allMaps, KERNELS_ULPS_TOLERANCE, caseDescription);
+		}
+		singleThreadMaps = std::move(featureMaps);
+	}
+
+	return mismatchesAmount;
+}
+
+/*
+Compare feature table with pixels of reference maps. Table columns are in the same order as maps, pixels where window
+does not fit the image have to be NaN.
+@param ulpsTolerance - allowed difference in float ulps, 0 when table and maps come from the same kernel.
+@return amount of differing values.
+*/
+unsigned long long compareFeatureTable(std::vector<std::unique_ptr<Image>>& reference, FeatureTable& featureTable, std::vector<unsigned int> windowSizes, unsigned int ulpsTolerance, std::string description) {
+	cv::Mat values = featureTable.getValues();
+	std::vector<cv::Point> points = featureTable.getPoints();
+	if (values.rows != static_cast<int>(points.size()) || values.cols != static_cast<int>(reference.size())) {
+		std::cerr << description << ": table has " << values.rows << " x " << values.cols << " values instead of " << points.size() << " x " << reference.size() << "\n";
+		return 1;
+	}
+
+	size_t featuresAmount = reference.size() / windowSizes.size();
+	unsigned long long mismatchesAmount = 0;
+	for (int row = 0; row < values.rows; row++) {
+		cv::Point point = points[row];
+		for (int column = 0; column < values.cols; column++) {
+			int windowSize = static_cast<int>(windowSizes[column / featuresAmount]);
+			int halfWindow = windowSize / 2;
+			bool windowInside = point.y >= halfWindow && point.y < TEXTURE_HEIGHT - windowSize + halfWindow &&
+				point.x >= halfWindow && point.x < TEXTURE_WIDTH - windowSize + halfWindow;
+			float expectedValue = windowInside ? reference[column]->getImage().at<float>(point.y, point.x) : std::numeric_limits<float>::quiet_NaN();
+			float actualValue = values.at<float>(row, column);
+			if (areValuesEqual(expectedValue, actualValue, ulpsTolerance)) {
+				continue;
+			}
+
+			if (mismatchesAmount < MAX_REPORTED_MISMATCHES) {
+				std::cerr << description << ": table column " << featureTable.getColumnNames()[column] << " at (" << point.y << ", " << point.x
+					<< ") is " << actualValue << " instead of " << expectedValue << "\n";
+			}
+			mismatchesAmount++;
+		}
+	}
+
+	return mismatchesAmount;
+}
+
+/*
+Compare features of random GLCMs evaluated by kernels of every SIMD level supported by CPU and by fixed size kernels
+with generic scalar kernel. Counts go above entropy table, so both table and std::log are used.
+@return amount of differing values.
+*/
+unsigned long long compareFeatureKernels() {
+	unsigned long long state = KERNEL_SEED;
+	unsigned long long mismatchesAmount = 0;
+	SimdLevel supportedLevel = detectSimdLevel();
+	for (unsigned int size : { 8u, 13u, 16u, 24u, 32u, 64u }) {
+		FeatureWeights weights = makeFeatureWeights(size);
+		weights.countLogCount = makeCountLogCountTable(MAX_ENTROPY_TABLE_COUNT);
+		for (int n = 0; n < KERNEL_GLCMS_AMOUNT; n++) {
+			std::vector<unsigned long long> counts(size * size);
+			unsigned long long pairsAmount = 0;
+			for (auto& count : counts) {
+				// about half of cells empty, some counts bigger than entropy table
+				count = nextRandom(state) % 2 == 0 ? 0 : nextRandom(state) % (MAX_ENTROPY_TABLE_COUNT * 4ULL);
+				pairsAmount += count;
+			}
+			GLCMView glcm{ counts.data(), size, pairsAmount };
+			FeatureValues expected = calcFeatureValuesGeneric(glcm, weights, true);
+
+			for (SimdLevel simdLevel : { SIMD_NONE, SIMD_SSE2, SIMD_AVX2 }) {
+				if (simdLevel > supportedLevel) {
+					continue;
+				}
+
+				FeatureValues actual = calcFeatureValues(glcm, weights, true, simdLevel);
+				std::pair<double, double> values[] = { { expected.energy, actual.energy }, { expected.entropy, actual.entropy },
+					{ expected.contrast, actual.contrast }, { expected.homogeneity, actual.homogeneity } };
+				for (auto [expectedValue, actualValue] : values) {
+					if (std::abs(actualValue - expectedValue) <= KERNEL_RELATIVE_TOLERANCE * std::abs(expectedValue)) {
+						continue;
+					}
+
+					if (mismatchesAmount < MAX_REPORTED_MISMATCHES) {
+						std::cerr << "kernel of SIMD level " << simdLevel << ", size " << size << ": " << actualValue << " instead of " << expectedValue << "\n";
+					}
+					mismatchesAmount++;
+				}
+			}
+		}
+	}
+
+	return mismatchesAmount;
+}
+
+int main() {
+	cv::Mat texture = createTexture();
+	std::vector<unsigned int> windowSizes = { 3, 5, 9 };
+	std::set<FeatureType> featureTypes = { ENERGY, ENTROPY, CONTRAST, HOMOGENEITY };
+
+	std::vector<TestCase> testCases;
+	for (ComputationMode computationMode : { BRUTE_FORCE, SLIDING_WINDOW, INTEGRAL_HISTOGRAMS, COLUMN_HISTOGRAMS }) {
+		for (GLCMStorage storage : { FULL_MATRIX, SPARSE_MATRIX, SUM_DIFF_HISTOGRAMS }) {
+			for (unsigned int threadsAmount : { 1u, 3u }) {
+				testCases.push_back(TestCase{ computationMode, storage, threadsAmount });
+			}
+		}
+	}
+
+	unsigned long long mismatchesAmount = compareFeatureKernels();
+	unsigned int checksAmount = 1;
+	// 64 gray levels make FULL_MATRIX switch to sparse GLCM for small windows
+	for (int grayLevelsAmount : { 8, 64 }) {
+		std::shared_ptr<Image> image = std::make_shared<Image>("test/source/texture.pgm", texture.clone(), grayLevelsAmount, 256);
+		for (bool meanGLCM : { true, false }) {
+			std::vector<std::pair<int, int>> offsets = meanGLCM ? std::vector<std::pair<int, int>>{ {1, 0}, {0, 1}, {1, 1}, {-1, 1} } : std::vector<std::pair<int, int>>{ {2, -1} };
+			ReferenceMaps reference = calcReferenceMaps(image, windowSizes, offsets, meanGLCM, featureTypes);
+
+			// whole image mask gives rows in row-major order, scattered points are unordered and repeated
+			cv::Mat mask(TEXTURE_HEIGHT, TEXTURE_WIDTH, CV_8UC1, cv::Scalar(1));
+			std::vector<cv::Point> points = { cv::Point(20, 16), cv::Point(0, 0), cv::Point(21, 16), cv::Point(7, 30), cv::Point(20, 16), cv::Point(40, 5), cv::Point(4, 4) };
+			for (auto testCase : testCases) {
+				if (testCase.computationMode != BRUTE_FORCE) {
+					continue;
+				}
+
+				// computation mode does not matter for tables, only storage and threads amount, storage of windows is chosen
+				// as in sliding window, so full matrix may be evaluated by other kernel than brute force maps
+				std::string description = "featureTable " + stringifyTestCase(testCase) + ", " + std::to_string(grayLevelsAmount) + " gray levels, " + (meanGLCM ? "mean GLCM" : "single offset");
+				std::unique_ptr<GLCM_features> glcmFeatures = std::make_unique<GLCM_features>(image, windowSizes);
+				glcmFeatures->setThreadsAmount(testCase.threadsAmount);
+				glcmFeatures->setGLCMStorage(testCase.storage);
+				std::vector<std::unique_ptr<Image>>& expectedMaps = testCase.storage == SUM_DIFF_HISTOGRAMS ? reference.sumDiff : (testCase.storage == SPARSE_MATRIX ? reference.sparse : reference.full);
+				unsigned int ulpsTolerance = testCase.storage == FULL_MATRIX ? KERNELS_ULPS_TOLERANCE : 0;
+				for (bool masked : { true, false }) {
+					FeatureTable featureTable = meanGLCM ?
+						(masked ? glcmFeatures->featureTable(offsets, featureTypes, mask) : glcmFeatures->featureTable(offsets, featureTypes, points)) :
+						(masked ? glcmFeatures->featureTable(offsets.front(), featureTypes, mask) : glcmFeatures->featureTable(offsets.front(), featureTypes, points));
+					mismatchesAmount += compareFeatureTable(expectedMaps, featureTable, windowSizes, ulpsTolerance, description);
+					checksAmount++;
+				}
+			}
+
+			std::string description = std::to_string(grayLevelsAmount) + " gray levels, " + (meanGLCM ? "mean GLCM" : "single offset");
+			mismatchesAmount += compareTestCases(image, testCases, windowSizes, offsets, meanGLCM, featureTypes, reference, description);
+			checksAmount += static_cast<unsigned int>(testCases.size());
+		}
+	}
+
+	// least common multiple of pairs amounts of these offsets does not fit integer counts in windows of 27 and more
+	std::vector<unsigned int> bigWindowSizes = { 27, 31 };
+	std::vector<std::pair<int, int>> longOffsets;
+	for (int d = 1; d <= LONG_OFFSETS_MAX_DISTANCE; d++) {
+		longOffsets.insert(longOffsets.end(), { {d, 0}, {0, d}, {d, d}, {-d, d} });
+	}
+	for (int grayLevelsAmount : { 8, 64 }) {
+		std::shared_ptr<Image> image = std::make_shared<Image>("test/source/texture.pgm", texture.clone(), grayLevelsAmount, 256);
+		ReferenceMaps reference = calcReferenceMaps(image, bigWindowSizes, longOffsets, true, featureTypes);
+		std::string description = std::to_string(grayLevelsAmount) + " gray levels, mean GLCM of " + std::to_string(longOffsets.size()) + " offsets";
+		mismatchesAmount += compareMeanGLCMFeatures(image, reference.full, bigWindowSizes, longOffsets, description);
+		mismatchesAmount += compareTestCases(image, testCases, bigWindowSizes, longOffsets, true, featureTypes, reference, description);
+		checksAmount += static_cast<unsigned int>(testCases.size()) + 1;
+	}
+
+	if (mismatchesAmount > 0) {
+		std::cerr << "FAILED: " << mismatchesAmount << " values differ from brute force\n";
+		return 1;
+	}
+
+	std::cout << "Passed " << checksAmount << " equivalence checks\n";
+	return 0;
+}